@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// Minimal benchmark harness shared by the programs in bench/
+// ============================================================================
+//
+// Each program collects results in a Report and prints it to stdout as
+// JSON, so runs can be diffed between releases:
+//
+//   {
+//     "suite": "coroutine_bench",
+//     "results": [
+//       {"name": "generator/create_destroy", "iterations": 1000000,
+//        "ns_per_op": 7.1, "ops_per_sec": 140845070.4, "counters": {}}
+//     ]
+//   }
+
+namespace bench {
+
+// Keeps the optimizer from discarding a value that is otherwise unused
+template<typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct Result {
+    std::string name;
+    long iterations = 0;
+    double ns_per_op = 0;
+    std::vector<std::pair<std::string, double>> counters;
+
+    Result& counter(std::string key, double value) {
+        counters.emplace_back(std::move(key), value);
+        return *this;
+    }
+};
+
+class Report {
+public:
+    explicit Report(std::string suite) : suite_(std::move(suite)) {}
+
+    Result& add(std::string name, long iterations, double total_ns) {
+        Result result;
+        result.name = std::move(name);
+        result.iterations = iterations;
+        result.ns_per_op = iterations > 0 ? total_ns / static_cast<double>(iterations) : 0;
+        results_.push_back(std::move(result));
+        return results_.back();
+    }
+
+    void write(std::ostream& out) const {
+        out << "{\n  \"suite\": \"" << escaped(suite_) << "\",\n  \"results\": [";
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const Result& r = results_[i];
+            out << (i ? ",\n" : "\n") << "    {\"name\": \"" << escaped(r.name)
+                << "\", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.ns_per_op
+                << ", \"ops_per_sec\": " << (r.ns_per_op > 0 ? 1e9 / r.ns_per_op : 0)
+                << ", \"counters\": {";
+            for (std::size_t c = 0; c < r.counters.size(); ++c) {
+                out << (c ? ", " : "") << "\"" << escaped(r.counters[c].first)
+                    << "\": " << r.counters[c].second;
+            }
+            out << "}}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+    static std::string escaped(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    std::string suite_;
+    std::vector<Result> results_;
+};
+
+template<typename Body>
+double elapsed_ns(Body&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+// Runs body(iterations) `repetitions` times and records the fastest run,
+// which is the least disturbed by the rest of the machine
+template<typename Body>
+Result& run(Report& report, std::string name, long iterations, Body&& body, int repetitions = 3) {
+    double best = 0;
+    for (int i = 0; i < repetitions; ++i) {
+        double ns = elapsed_ns([&] { body(iterations); });
+        best = i == 0 ? ns : std::min(best, ns);
+    }
+    return report.add(std::move(name), iterations, best);
+}
+
+// Positional integer argument with a default
+inline long arg(int argc, char** argv, int index, long fallback) {
+    return argc > index ? std::atol(argv[index]) : fallback;
+}
+
+}  // namespace bench
@@ -0,0 +1,202 @@
+// Benchmark: Channel<T> against a mutex + condition_variable queue
+//
+// `pairs` producers each send `items` integers through one bounded queue to
+// `pairs` consumers. The Channel version runs producers and consumers as
+// coroutines on a Scheduler with `pairs` workers. The baseline runs them as
+// std::threads blocking on a std::condition_variable. Both are measured
+// with a large buffer and with a single slot, where nearly every send or
+// recv has to wait.
+//
+// "channel/chain" passes a few values down a long line of coroutines, each
+// stage receiving from one single-slot channel and sending to the next, all
+// on the calling thread. Every send resumes the next stage, so it checks
+// that hand-offs do not nest: with nested resumes, the stack would grow
+// with the number of stages.
+//
+// Usage: channel_bench [pairs] [items_per_producer] [chain_stages]
+//   defaults: 4 pairs, 200000 items each, 200000 stages
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "channel.h"
+#include "lazy_task.h"
+#include "scheduler.h"
+#include "sync_wait.h"
+#include "task.h"
+#include "when_all.h"
+
+namespace {
+
+LazyTask<long> produce(Scheduler& scheduler, Channel<long>& channel, long items) {
+    co_await scheduler.schedule();
+    long sum = 0;
+    for (long i = 0; i < items; ++i) {
+        co_await channel.send(i);
+        sum += i;
+    }
+    co_return sum;
+}
+
+LazyTask<long> consume(Scheduler& scheduler, Channel<long>& channel) {
+    co_await scheduler.schedule();
+    long sum = 0;
+    while (std::optional<long> value = co_await channel.recv()) sum += *value;
+    co_return sum;
+}
+
+LazyTask<long> produce_all(Scheduler& scheduler, Channel<long>& channel, int producers, long items) {
+    std::vector<LazyTask<long>> tasks;
+    for (int p = 0; p < producers; ++p) tasks.push_back(produce(scheduler, channel, items));
+    long sum = 0;
+    for (long part : co_await when_all(std::move(tasks))) sum += part;
+    channel.close();
+    co_return sum;
+}
+
+LazyTask<long> consume_all(Scheduler& scheduler, Channel<long>& channel, int consumers) {
+    std::vector<LazyTask<long>> tasks;
+    for (int c = 0; c < consumers; ++c) tasks.push_back(consume(scheduler, channel));
+    long sum = 0;
+    for (long part : co_await when_all(std::move(tasks))) sum += part;
+    co_return sum;
+}
+
+void run_channel(bench::Report& report, const char* name, int pairs, long items, std::size_t capacity) {
+    long sent = 0;
+    long received = 0;
+    double ns = bench::elapsed_ns([&] {
+        Scheduler scheduler(static_cast<unsigned>(pairs));
+        Channel<long> channel(capacity);
+        auto [s, r] = sync_wait(when_all(produce_all(scheduler, channel, pairs, items),
+                                         consume_all(scheduler, channel, pairs)));
+        sent = s;
+        received = r;
+    });
+    if (sent != received) std::cerr << name << ": sums differ\n";
+    report.add(name, pairs * items, ns).counter("pairs", pairs).counter("capacity", static_cast<double>(capacity));
+}
+
+Task<long> forward(Channel<long>& in, Channel<long>& out) {
+    while (std::optional<long> value = co_await in.recv()) co_await out.send(*value + 1);
+    out.close();
+    co_return 0;
+}
+
+Task<long> drain(Channel<long>& channel) {
+    long sum = 0;
+    while (std::optional<long> value = co_await channel.recv()) sum += *value;
+    co_return sum;
+}
+
+void run_chain(bench::Report& report, long stages, long items) {
+    long sum = 0;
+    double ns = bench::elapsed_ns([&] {
+        std::vector<std::unique_ptr<Channel<long>>> channels;
+        for (long i = 0; i <= stages; ++i) channels.push_back(std::make_unique<Channel<long>>(1));
+        std::vector<Task<long>> line;
+        for (long i = 0; i < stages; ++i) line.push_back(forward(*channels[i], *channels[i + 1]));
+        Task<long> last = drain(*channels[stages]);
+
+        // Each send runs until the value has moved as far down the line as
+        // the full slots allow
+        auto source = [&]() -> Task<long> {
+            for (long i = 0; i < items; ++i) co_await channels[0]->send(i);
+            channels[0]->close();
+            co_return 0;
+        };
+        sync_wait(source());
+        sum = sync_wait(std::move(last));
+    });
+    // Every value gains one per stage
+    if (sum != items * (items - 1) / 2 + items * stages) std::cerr << "channel/chain: wrong sum " << sum << "\n";
+    report.add("channel/chain", stages * items, ns).counter("stages", static_cast<double>(stages));
+}
+
+// The queue a Channel replaces
+class BlockingQueue {
+public:
+    explicit BlockingQueue(std::size_t capacity) : capacity_(capacity) {}
+
+    void push(long value) {
+        std::unique_lock lock(mutex_);
+        not_full_.wait(lock, [&] { return items_.size() < capacity_; });
+        items_.push_back(value);
+        not_empty_.notify_one();
+    }
+
+    std::optional<long> pop() {
+        std::unique_lock lock(mutex_);
+        not_empty_.wait(lock, [&] { return !items_.empty() || closed_; });
+        if (items_.empty()) return std::nullopt;
+        long value = items_.front();
+        items_.pop_front();
+        not_full_.notify_one();
+        return value;
+    }
+
+    void close() {
+        std::lock_guard lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    std::size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<long> items_;
+    bool closed_ = false;
+};
+
+void run_blocking(bench::Report& report, const char* name, int pairs, long items, std::size_t capacity) {
+    double ns = bench::elapsed_ns([&] {
+        BlockingQueue queue(capacity);
+        std::vector<std::thread> producers;
+        std::vector<std::thread> consumers;
+        for (int c = 0; c < pairs; ++c) {
+            consumers.emplace_back([&] {
+                long sum = 0;
+                while (std::optional<long> value = queue.pop()) sum += *value;
+                bench::do_not_optimize(sum);
+            });
+        }
+        for (int p = 0; p < pairs; ++p) {
+            producers.emplace_back([&] {
+                for (long i = 0; i < items; ++i) queue.push(i);
+            });
+        }
+        for (auto& t : producers) t.join();
+        queue.close();
+        for (auto& t : consumers) t.join();
+    });
+    report.add(name, pairs * items, ns).counter("pairs", pairs).counter("capacity", static_cast<double>(capacity));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int pairs = static_cast<int>(bench::arg(argc, argv, 1, 4));
+    const long items = bench::arg(argc, argv, 2, 200000);
+    const long stages = bench::arg(argc, argv, 3, 200000);
+
+    bench::Report report("channel_bench");
+
+    run_channel(report, "channel/capacity_1024", pairs, items, 1024);
+    run_blocking(report, "mutex_condvar/capacity_1024", pairs, items, 1024);
+    run_channel(report, "channel/capacity_1", pairs, items, 1);
+    run_blocking(report, "mutex_condvar/capacity_1", pairs, items, 1);
+    run_chain(report, stages, 3);
+
+    report.write(std::cout);
+    return 0;
+}
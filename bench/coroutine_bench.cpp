@@ -0,0 +1,159 @@
+// Benchmark suite: cost of the basic coroutine primitives
+//
+// Prints a JSON report (see bench.h) covering frame create/destroy, the
+// resume/suspend round trip, generator throughput (one element or one batch
+// per resume) and task chain depth.
+//
+// Usage: coroutine_bench [iterations]
+//   default: 1000000
+
+#include <algorithm>
+#include <iostream>
+#include <ranges>
+#include <span>
+#include <string>
+
+#include "batched_generator.h"
+#include "bench.h"
+#include "generator.h"
+#include "lazy_task.h"
+#include "sync_wait.h"
+#include "task.h"
+
+namespace {
+
+Generator<int> counter() {
+    for (int i = 0;; ++i) co_yield i;
+}
+
+Generator<int> range(int start, int end) {
+    for (int i = start; i < end; ++i) co_yield i;
+}
+
+BatchedGenerator<int> batched_range(int start, int end) {
+    for (int i = start; i < end; ++i) co_yield i;
+}
+
+// The whole range in one co_yield: batches are copied without resuming
+BatchedGenerator<int> bulk_range(int start, int end) {
+    co_yield elements_of(std::views::iota(start, end));
+}
+
+Generator<long> fibonacci(int count) {
+    long a = 0, b = 1;
+    for (int i = 0; i < count; ++i) {
+        co_yield a;
+        long next = a + b;
+        a = b;
+        b = next;
+    }
+}
+
+Task<int> eager_task() {
+    co_return 1;
+}
+
+LazyTask<int> leaf_task() {
+    co_return 1;
+}
+
+// Each level awaits the next one; the innermost level returns first
+LazyTask<int> chain(int depth) {
+    if (depth == 0) co_return 0;
+    co_return 1 + co_await chain(depth - 1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const long iterations = bench::arg(argc, argv, 1, 1000000);
+    bench::Report report("coroutine_bench");
+
+    bench::run(report, "generator/create_destroy", iterations, [](long n) {
+        for (long i = 0; i < n; ++i) {
+            auto gen = counter();
+            bench::do_not_optimize(gen.handle);
+        }
+    });
+
+    bench::run(report, "lazy_task/create_destroy", iterations, [](long n) {
+        for (long i = 0; i < n; ++i) {
+            auto task = leaf_task();
+            bench::do_not_optimize(task.handle);
+        }
+    });
+
+    // Eager: creating the task also runs it to completion
+    bench::run(report, "task/create_run_destroy", iterations, [](long n) {
+        for (long i = 0; i < n; ++i) {
+            auto task = eager_task();
+            bench::do_not_optimize(task.handle);
+        }
+    });
+
+    bench::run(report, "generator/resume_suspend", iterations, [](long n) {
+        auto gen = counter();
+        for (long i = 0; i < n; ++i) {
+            gen.next();
+            bench::do_not_optimize(gen.value());
+        }
+    });
+
+    bench::run(report, "generator/range_throughput", iterations, [](long n) {
+        long sum = 0;
+        for (int v : range(0, static_cast<int>(n))) sum += v;
+        bench::do_not_optimize(sum);
+    });
+
+    // Same body, but resumed once per 256 elements; the inner loop vectorizes
+    bench::run(report, "generator/range_batched_throughput", iterations, [](long n) {
+        long sum = 0;
+        for (std::span<int> batch : batched_range(0, static_cast<int>(n))) {
+            for (int v : batch) sum += v;
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    bench::run(report, "generator/range_bulk_throughput", iterations, [](long n) {
+        long sum = 0;
+        for (std::span<int> batch : bulk_range(0, static_cast<int>(n))) {
+            for (int v : batch) sum += v;
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    // Sequences restart every 90 elements to stay within a long
+    bench::run(report, "generator/fibonacci_throughput", iterations, [](long n) {
+        long sum = 0;
+        for (long done = 0; done < n; done += 90) {
+            for (long v : fibonacci(static_cast<int>(std::min<long>(90, n - done)))) sum += v;
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    bench::run(report, "task/get", iterations / 10, [](long n) {
+        for (long i = 0; i < n; ++i) {
+            bench::do_not_optimize(eager_task().get());
+        }
+    });
+
+    bench::run(report, "lazy_task/sync_wait", iterations / 10, [](long n) {
+        for (long i = 0; i < n; ++i) {
+            bench::do_not_optimize(sync_wait(leaf_task()));
+        }
+    });
+
+    for (int depth : {1, 10, 100, 1000}) {
+        long runs = std::max<long>(1, iterations / 10 / depth);
+        auto& result = bench::run(report, "lazy_task/chain_depth_" + std::to_string(depth), runs,
+                                  [depth](long n) {
+                                      for (long i = 0; i < n; ++i) {
+                                          bench::do_not_optimize(sync_wait(chain(depth)));
+                                      }
+                                  });
+        result.counter("depth", depth).counter("ns_per_level", result.ns_per_op / depth);
+    }
+
+    report.write(std::cout);
+    return 0;
+}
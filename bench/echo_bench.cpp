@@ -0,0 +1,134 @@
+// Benchmark: request/response echo over loopback TCP and a Unix socket
+//
+// One process runs both sides on the shared Reactor: an accept loop spawns
+// an echo coroutine per connection, and `connections` client coroutines
+// each send `requests` fixed-size messages, waiting for every echo before
+// sending the next. Reported per transport: time per request, requests per
+// second, and requests per second per core of CPU time actually used.
+//
+// Usage: echo_bench [connections] [requests] [message_bytes]
+//   defaults: 64 connections, 2000 requests each, 64 bytes
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "bench.h"
+#include "socket.h"
+
+namespace {
+
+// Fire-and-forget coroutine: frees its own frame when the body finishes
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+std::atomic<int> remaining{0};
+
+void finished() {
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        remaining.notify_one();
+    }
+}
+
+Detached echo(Socket socket, std::size_t message_bytes) {
+    std::vector<std::byte> buffer(message_bytes);
+    while (std::size_t n = co_await socket.recv(buffer)) {
+        for (std::size_t sent = 0; sent < n;) {
+            sent += co_await socket.send(std::span(buffer).subspan(sent, n - sent));
+        }
+    }
+    finished();
+}
+
+Detached accept_loop(Socket& server, int connections, std::size_t message_bytes) {
+    for (int i = 0; i < connections; ++i) {
+        echo(co_await server.accept(), message_bytes);
+    }
+}
+
+Detached client(SocketAddress address, int requests, std::size_t message_bytes) {
+    Socket socket = co_await Socket::connect(address);
+    std::vector<std::byte> message(message_bytes, std::byte{'x'});
+    std::vector<std::byte> reply(message_bytes);
+
+    for (int r = 0; r < requests; ++r) {
+        for (std::size_t sent = 0; sent < message_bytes;) {
+            sent += co_await socket.send(std::span(message).subspan(sent));
+        }
+        for (std::size_t received = 0; received < message_bytes;) {
+            std::size_t n = co_await socket.recv(std::span(reply).subspan(received));
+            if (n == 0) std::terminate();  // The server never closes first
+            received += n;
+        }
+    }
+    socket.close();
+    finished();
+}
+
+double cpu_seconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    auto seconds = [](timeval t) { return static_cast<double>(t.tv_sec) + static_cast<double>(t.tv_usec) / 1e6; };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+}
+
+void run(bench::Report& report, const char* name, const SocketAddress& address, int connections, int requests,
+         std::size_t message_bytes) {
+    Socket server = Socket::listen(address);
+    SocketAddress bound = server.local_address();
+
+    const double cpu_before = cpu_seconds();
+    double ns = bench::elapsed_ns([&] {
+        remaining.store(2 * connections);  // Clients and their echo coroutines
+        accept_loop(server, connections, message_bytes);
+        for (int c = 0; c < connections; ++c) {
+            client(bound, requests, message_bytes);
+        }
+        for (int left = remaining.load(); left != 0; left = remaining.load()) {
+            remaining.wait(left);
+        }
+    });
+    const double cpu = cpu_seconds() - cpu_before;
+
+    double total = static_cast<double>(connections) * requests;
+    report.add(name, static_cast<long>(total), ns)
+        .counter("connections", connections)
+        .counter("message_bytes", static_cast<double>(message_bytes))
+        .counter("requests_per_sec", total / (ns / 1e9))
+        .counter("requests_per_sec_per_core", cpu > 0 ? total / cpu : 0)
+        .counter("cores_used", cpu / (ns / 1e9));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int connections = static_cast<int>(bench::arg(argc, argv, 1, 64));
+    const int requests = static_cast<int>(bench::arg(argc, argv, 2, 2000));
+    const auto message_bytes = static_cast<std::size_t>(bench::arg(argc, argv, 3, 64));
+
+    bench::Report report("echo_bench");
+
+    run(report, "echo/tcp_loopback", SocketAddress::ipv4("127.0.0.1", 0), connections, requests, message_bytes);
+
+    auto path = std::filesystem::temp_directory_path() / "coroutine_echo_bench.sock";
+    std::filesystem::remove(path);
+    run(report, "echo/unix", SocketAddress::unix_path(path.string()), connections, requests, message_bytes);
+    std::filesystem::remove(path);
+
+    report.write(std::cout);
+    return 0;
+}
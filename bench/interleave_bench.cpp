@@ -0,0 +1,165 @@
+// Benchmark: batches of lookups in tables larger than the last-level cache
+//
+// "sequential" probes one key after another with plain functions, so every
+// cache miss is paid in full. "interleaved/N" runs the same probes as
+// coroutines on an InterleavedExecutor with N of them in flight, each one
+// prefetching before it reads. Two workloads: an open-addressing hash table
+// (one or two misses per lookup) and binary search over a sorted array (a
+// miss on most levels below the cached top of the search tree).
+//
+// Each table takes table_mb megabytes; pick more than the LLC size. They are
+// built one after the other, so peak memory is about table_mb.
+//
+// Usage: interleave_bench [table_mb] [lookups]
+//   defaults: 1024, 1000000
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "interleave.h"
+
+namespace {
+
+// splitmix64 finalizer: a bijection, so distinct indices give distinct keys
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+struct Entry {
+    std::uint64_t key;  // 0 marks an empty slot
+    std::uint64_t value;
+};
+
+// Linear probing, power-of-two size, at most half full
+class HashTable {
+public:
+    explicit HashTable(std::size_t bytes) {
+        std::size_t slots = 1;
+        while (slots * 2 * sizeof(Entry) <= bytes) slots *= 2;
+        mask_ = slots - 1;
+        slots_ = std::make_unique<Entry[]>(slots);
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    void insert(std::uint64_t key, std::uint64_t value) {
+        std::size_t i = slot_of(key);
+        while (slots_[i].key != 0) i = (i + 1) & mask_;
+        slots_[i] = Entry{key, value};
+    }
+
+    std::uint64_t find(std::uint64_t key) const {
+        for (std::size_t i = slot_of(key);; i = (i + 1) & mask_) {
+            const Entry& entry = slots_[i];
+            if (entry.key == key) return entry.value;
+            if (entry.key == 0) return 0;
+        }
+    }
+
+    Interleaved<std::uint64_t> find_interleaved(std::uint64_t key) const {
+        for (std::size_t i = slot_of(key);; i = (i + 1) & mask_) {
+            const Entry& entry = slots_[i];
+            co_await prefetch(&entry);
+            if (entry.key == key) co_return entry.value;
+            if (entry.key == 0) co_return 0;
+        }
+    }
+
+private:
+    std::size_t slot_of(std::uint64_t key) const { return mix(key) & mask_; }
+
+    std::unique_ptr<Entry[]> slots_;
+    std::size_t mask_ = 0;
+};
+
+// Position of the first element not less than key
+std::size_t lower_bound(const std::uint64_t* data, std::size_t size, std::uint64_t key) {
+    const std::uint64_t* base = data;
+    while (size > 1) {
+        std::size_t half = size / 2;
+        base = base[half] < key ? base + half : base;
+        size -= half;
+    }
+    return static_cast<std::size_t>(base - data) + (*base < key);
+}
+
+Interleaved<std::size_t> lower_bound_interleaved(const std::uint64_t* data, std::size_t size, std::uint64_t key) {
+    const std::uint64_t* base = data;
+    while (size > 1) {
+        std::size_t half = size / 2;
+        co_await prefetch(base + half);
+        base = base[half] < key ? base + half : base;
+        size -= half;
+    }
+    co_return static_cast<std::size_t>(base - data) + (*base < key);
+}
+
+constexpr std::size_t group_sizes[] = {1, 4, 8, 16, 32};
+
+template<typename Sequential, typename MakeLookup>
+void compare(bench::Report& report, const std::string& table, const std::vector<std::uint64_t>& keys,
+             double table_mb, Sequential sequential, MakeLookup make) {
+    const long lookups = static_cast<long>(keys.size());
+
+    bench::run(report, table + "/sequential", lookups, [&](long) {
+        std::uint64_t checksum = 0;
+        for (std::uint64_t key : keys) checksum += sequential(key);
+        bench::do_not_optimize(checksum);
+    }).counter("table_mb", table_mb);
+
+    for (std::size_t group : group_sizes) {
+        InterleavedExecutor executor(group);
+        bench::run(report, table + "/interleaved/" + std::to_string(group), lookups, [&](long) {
+            std::uint64_t checksum = 0;
+            executor.run(keys, make, [&](std::size_t, std::uint64_t result) { checksum += result; });
+            bench::do_not_optimize(checksum);
+        }).counter("table_mb", table_mb).counter("group_size", static_cast<double>(group));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t table_bytes = static_cast<std::size_t>(bench::arg(argc, argv, 1, 1024)) << 20;
+    const long lookups = bench::arg(argc, argv, 2, 1'000'000);
+    const double table_mb = static_cast<double>(table_bytes >> 20);
+    bench::Report report("interleave_bench");
+
+    std::vector<std::uint64_t> keys(static_cast<std::size_t>(lookups));
+
+    {
+        HashTable table(table_bytes);
+        const std::size_t count = table.capacity() / 2;
+        for (std::size_t i = 0; i < count; ++i) table.insert(mix(i + 1), i + 1);
+        for (std::size_t i = 0; i < keys.size(); ++i) keys[i] = mix(mix(i) % count + 1);
+
+        compare(report, "hash", keys, table_mb,
+                [&](std::uint64_t key) { return table.find(key); },
+                [&](std::uint64_t key) { return table.find_interleaved(key); });
+    }
+
+    {
+        const std::size_t size = table_bytes / sizeof(std::uint64_t);
+        auto sorted = std::make_unique<std::uint64_t[]>(size);
+        for (std::size_t i = 0; i < size; ++i) sorted[i] = 2 * i;
+        for (std::size_t i = 0; i < keys.size(); ++i) keys[i] = 2 * (mix(i) % size);
+
+        const std::uint64_t* data = sorted.get();
+        compare(report, "binary_search", keys, table_mb,
+                [&](std::uint64_t key) { return lower_bound(data, size, key); },
+                [&](std::uint64_t key) { return lower_bound_interleaved(data, size, key); });
+    }
+
+    report.write(std::cout);
+    return 0;
+}
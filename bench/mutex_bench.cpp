@@ -0,0 +1,116 @@
+// Benchmark: AsyncMutex / AsyncSharedMutex against std::mutex / std::shared_mutex
+//
+// N threads (or N coroutines on a Scheduler with N workers) each take the
+// lock `iterations` times around a tiny critical section, for N = 1, 2, 4,
+// ..., up to `max_threads`. The reader-writer runs make every tenth
+// acquisition exclusive and the rest shared.
+//
+// Usage: mutex_bench [max_threads] [iterations_per_thread]
+//   defaults: 64 threads, 20000 iterations each
+
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_mutex.h"
+#include "bench.h"
+#include "lazy_task.h"
+#include "scheduler.h"
+#include "sync_wait.h"
+#include "when_all.h"
+
+namespace {
+
+long shared_counter = 0;
+
+template<typename Body>
+double run_threads(int threads, Body body) {
+    return bench::elapsed_ns([&] {
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) pool.emplace_back(body);
+        for (auto& thread : pool) thread.join();
+    });
+}
+
+LazyTask<int> lock_loop(Scheduler& scheduler, AsyncMutex& mutex, long iterations) {
+    co_await scheduler.schedule();
+    for (long i = 0; i < iterations; ++i) {
+        auto lock = co_await mutex.scoped_lock();
+        ++shared_counter;
+    }
+    co_return 0;
+}
+
+LazyTask<int> rw_loop(Scheduler& scheduler, AsyncSharedMutex& mutex, long iterations) {
+    co_await scheduler.schedule();
+    for (long i = 0; i < iterations; ++i) {
+        if (i % 10 == 0) {
+            auto lock = co_await mutex.scoped_lock();
+            ++shared_counter;
+        } else {
+            auto lock = co_await mutex.scoped_lock_shared();
+            bench::do_not_optimize(shared_counter);
+        }
+    }
+    co_return 0;
+}
+
+template<typename Mutex, typename Loop>
+double run_coroutines(int threads, long iterations, Loop loop) {
+    return bench::elapsed_ns([&] {
+        Scheduler scheduler(static_cast<unsigned>(threads));
+        Mutex mutex;
+        std::vector<LazyTask<int>> tasks;
+        for (int t = 0; t < threads; ++t) tasks.push_back(loop(scheduler, mutex, iterations));
+        sync_wait(when_all(std::move(tasks)));
+    });
+}
+
+void add(bench::Report& report, const std::string& name, int threads, long iterations, double ns) {
+    report.add(name + "/threads_" + std::to_string(threads), threads * iterations, ns).counter("threads", threads);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int max_threads = static_cast<int>(bench::arg(argc, argv, 1, 64));
+    const long iterations = bench::arg(argc, argv, 2, 20000);
+
+    bench::Report report("mutex_bench");
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::mutex mutex;
+        add(report, "std_mutex", threads, iterations, run_threads(threads, [&] {
+                for (long i = 0; i < iterations; ++i) {
+                    std::lock_guard lock(mutex);
+                    ++shared_counter;
+                }
+            }));
+        add(report, "async_mutex", threads, iterations,
+            run_coroutines<AsyncMutex>(threads, iterations, lock_loop));
+    }
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::shared_mutex mutex;
+        add(report, "std_shared_mutex", threads, iterations, run_threads(threads, [&] {
+                for (long i = 0; i < iterations; ++i) {
+                    if (i % 10 == 0) {
+                        std::lock_guard lock(mutex);
+                        ++shared_counter;
+                    } else {
+                        std::shared_lock lock(mutex);
+                        bench::do_not_optimize(shared_counter);
+                    }
+                }
+            }));
+        add(report, "async_shared_mutex", threads, iterations,
+            run_coroutines<AsyncSharedMutex>(threads, iterations, rw_loop));
+    }
+
+    bench::do_not_optimize(shared_counter);
+    report.write(std::cout);
+    return 0;
+}
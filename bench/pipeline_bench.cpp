@@ -0,0 +1,84 @@
+// Benchmark: map | filter | take over a generator
+//
+// "nested" writes each stage as its own Generator, so every element costs
+// one resume per stage. "fused" composes the stages with the operators in
+// pipeline.h and runs them in one loop over the source generator; only the
+// source resumes. "fused_generator" wraps the fused stages in a single
+// Generator, and "views" runs std::views adaptors over the same source for
+// reference.
+//
+// Usage: pipeline_bench [elements]
+//   defaults: 1000000
+
+#include <iostream>
+#include <ranges>
+#include <string>
+
+#include "bench.h"
+#include "generator.h"
+#include "pipeline.h"
+
+namespace {
+
+Generator<long> numbers(long end) {
+    for (long i = 0; i < end; ++i) co_yield i;
+}
+
+Generator<long> map_gen(Generator<long> source) {
+    for (long v : source) co_yield v * 3;
+}
+
+Generator<long> filter_gen(Generator<long> source) {
+    for (long v : source) {
+        if (v % 2 == 0) co_yield v;
+    }
+}
+
+Generator<long> take_gen(Generator<long> source, long count) {
+    if (count <= 0) co_return;
+    for (long v : source) {
+        co_yield v;
+        if (--count == 0) co_return;
+    }
+}
+
+auto triple = [](long v) { return v * 3; };
+auto is_even = [](long v) { return v % 2 == 0; };
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const long elements = bench::arg(argc, argv, 1, 1'000'000);
+    // Every other tripled value is even, so take() ends on the last one
+    const long taken = elements / 2;
+    bench::Report report("pipeline_bench");
+
+    bench::run(report, "nested", elements, [&](long n) {
+        long sum = 0;
+        for (long v : take_gen(filter_gen(map_gen(numbers(n))), taken)) sum += v;
+        bench::do_not_optimize(sum);
+    }).counter("frames", 4);
+
+    bench::run(report, "fused", elements, [&](long n) {
+        long sum = numbers(n) | fuse::map(triple) | fuse::filter(is_even) | fuse::take(taken) | fuse::reduce(0L);
+        bench::do_not_optimize(sum);
+    }).counter("frames", 1);
+
+    bench::run(report, "fused_generator", elements, [&](long n) {
+        long sum = 0;
+        auto gen = numbers(n) | fuse::map(triple) | fuse::filter(is_even) | fuse::take(taken) | fuse::to_generator();
+        for (long v : gen) sum += v;
+        bench::do_not_optimize(sum);
+    }).counter("frames", 2);
+
+    bench::run(report, "views", elements, [&](long n) {
+        long sum = 0;
+        for (long v : numbers(n) | std::views::transform(triple) | std::views::filter(is_even) | std::views::take(taken)) {
+            sum += v;
+        }
+        bench::do_not_optimize(sum);
+    }).counter("frames", 1);
+
+    report.write(std::cout);
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Benchmark: walking a binary tree with nested generators
+//
+// "re-yield" nests one generator per tree level and copies every element up
+// through each of them: O(depth) resumes per element. "elements_of"
+// delegates to the child generator, so the consumer resumes the leaf
+// directly: O(1) per element.
+//
+// Usage: recursive_gen_bench [balanced_depth] [skewed_depth]
+//   defaults: 20 (about 1M nodes), 2000
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "bench.h"
+#include "generator.h"
+
+namespace {
+
+struct Node {
+    int value;
+    std::unique_ptr<Node> left;
+    std::unique_ptr<Node> right;
+};
+
+std::unique_ptr<Node> balanced(int depth, int& next_value) {
+    if (depth == 0) return nullptr;
+    auto node = std::make_unique<Node>();
+    node->left = balanced(depth - 1, next_value);
+    node->value = next_value++;
+    node->right = balanced(depth - 1, next_value);
+    return node;
+}
+
+// Every node has only a right child: depth == node count
+std::unique_ptr<Node> skewed(int depth) {
+    std::unique_ptr<Node> root;
+    for (int i = depth - 1; i >= 0; --i) {
+        auto node = std::make_unique<Node>();
+        node->value = i;
+        node->right = std::move(root);
+        root = std::move(node);
+    }
+    return root;
+}
+
+void destroy_iteratively(std::unique_ptr<Node> node) {
+    // The recursive unique_ptr destructor would overflow on a skewed tree
+    while (node) node = std::move(node->right);
+}
+
+Generator<int> inorder_reyield(const Node* node) {
+    if (!node) co_return;
+    for (int v : inorder_reyield(node->left.get())) co_yield v;
+    co_yield node->value;
+    for (int v : inorder_reyield(node->right.get())) co_yield v;
+}
+
+Generator<int> inorder_nested(const Node* node) {
+    if (!node) co_return;
+    co_yield elements_of(inorder_nested(node->left.get()));
+    co_yield node->value;
+    co_yield elements_of(inorder_nested(node->right.get()));
+}
+
+template<typename Walk>
+void run(bench::Report& report, const std::string& name, const Node* root, long elements, int depth,
+         Walk walk) {
+    bench::run(report, name, elements, [&](long) {
+        long sum = 0;
+        for (int v : walk(root)) sum += v;
+        bench::do_not_optimize(sum);
+    }).counter("depth", depth);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int balanced_depth = static_cast<int>(bench::arg(argc, argv, 1, 20));
+    const int skewed_depth = static_cast<int>(bench::arg(argc, argv, 2, 2000));
+    bench::Report report("recursive_gen_bench");
+
+    int next_value = 0;
+    auto tree = balanced(balanced_depth, next_value);
+    run(report, "balanced/reyield", tree.get(), next_value, balanced_depth, inorder_reyield);
+    run(report, "balanced/elements_of", tree.get(), next_value, balanced_depth, inorder_nested);
+
+    auto chain = skewed(skewed_depth);
+    run(report, "skewed/reyield", chain.get(), skewed_depth, skewed_depth, inorder_reyield);
+    run(report, "skewed/elements_of", chain.get(), skewed_depth, skewed_depth, inorder_nested);
+    destroy_iteratively(std::move(chain));
+
+    report.write(std::cout);
+    return 0;
+}
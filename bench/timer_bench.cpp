@@ -0,0 +1,97 @@
+// Benchmark: many concurrent sleeps served by the shared TimerService
+//
+// Usage: timer_bench [sleepers] [sleep_ms]
+//   defaults: 100000 sleepers, 100ms each
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <iostream>
+
+#include <sys/resource.h>
+
+#include "bench.h"
+#include "timer_service.h"
+
+namespace {
+
+// Fire-and-forget coroutine: frees its own frame when the body finishes
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct TimerAwaiter {
+    TimerService::clock::time_point deadline;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const {
+        TimerService::instance().schedule(deadline, handle);
+    }
+    void await_resume() const noexcept {}
+};
+
+std::atomic<int> remaining{0};
+
+Detached sleeper(std::chrono::milliseconds duration) {
+    co_await TimerAwaiter{TimerService::clock::now() + duration};
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        remaining.notify_one();
+    }
+}
+
+long peak_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // Reported in bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int sleepers = static_cast<int>(bench::arg(argc, argv, 1, 100000));
+    const auto sleep = std::chrono::milliseconds(bench::arg(argc, argv, 2, 100));
+
+    TimerService::instance();  // Start the timer thread outside the timed region
+    const long rss_before = peak_rss_kb();
+
+    remaining.store(sleepers);
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < sleepers; ++i) {
+        sleeper(sleep);
+    }
+    auto registered = std::chrono::steady_clock::now();
+
+    for (int left = remaining.load(); left != 0; left = remaining.load()) {
+        remaining.wait(left);
+    }
+    auto finished = std::chrono::steady_clock::now();
+
+    using ns = std::chrono::nanoseconds;
+    double register_ns = static_cast<double>(std::chrono::duration_cast<ns>(registered - start).count());
+    double total_ns = static_cast<double>(std::chrono::duration_cast<ns>(finished - start).count());
+    double rss_growth = static_cast<double>(peak_rss_kb() - rss_before) * 1024.0;
+
+    bench::Report report("timer_bench");
+    report.add("timer/register_sleep", sleepers, register_ns)
+        .counter("sleepers", sleepers)
+        .counter("sleep_ms", static_cast<double>(sleep.count()));
+    report.add("timer/concurrent_sleeps", sleepers, total_ns)
+        .counter("last_wakeup_overshoot_us", (total_ns - static_cast<double>(ns(sleep).count())) / 1000.0)
+        .counter("peak_rss_growth_bytes", rss_growth)
+        .counter("rss_bytes_per_sleep", rss_growth / sleepers);
+    report.write(std::cout);
+
+    return 0;
+}
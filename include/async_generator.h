@@ -0,0 +1,245 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+
+#include "cancellation.h"
+#include "frame_allocator.h"
+#include "trace.h"
+
+// ============================================================================
+// AsyncGenerator - A generator that can co_await between its co_yields
+// ============================================================================
+//
+//   AsyncGenerator<Page> pages(File& file) {
+//       for (std::uint64_t offset = 0;; offset += page_size) {
+//           Page page;
+//           if (co_await file.read(offset, page.bytes) == 0) co_return;
+//           co_yield std::move(page);
+//       }
+//   }
+//
+//   while (co_await gen.next()) use(gen.value());
+//
+//   for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it) use(*it);
+//
+// Consumers are coroutines. Asking for the next element transfers control
+// straight into the producer by symmetric transfer, and co_yield (or the
+// end of the body) transfers straight back. Neither direction goes through
+// a scheduler or grows the stack. While the producer is suspended on
+// something else (a timer, a read), the consumer stays suspended too.
+//
+// Yielded values are not copied, just as with Generator: the consumer sees
+// the object named in co_yield until it asks for the next element.
+// Generator's reference forms apply: AsyncGenerator<T&> hands out T&, and
+// AsyncGenerator<T> offers take() to move an rvalue out.
+//
+// The producer runs with the stop token of the coroutine that first asks it
+// for an element (see cancellation.h).
+
+template<typename T>
+class AsyncGenerator {
+public:
+    using value_type = std::remove_cvref_t<T>;
+    using reference = std::conditional_t<std::is_reference_v<T>, T, const value_type&>;
+    using pointer = std::add_pointer_t<reference>;
+
+    struct promise_type : PooledFramePromise {
+        pointer current = nullptr;
+        bool movable = false;  // current names an rvalue the consumer may steal
+        bool started = false;
+        std::exception_ptr exception;
+        std::coroutine_handle<> consumer;
+        std::stop_token stop_token;
+
+        ~promise_type() { COROUTINE_TRACE_DESTROY(trace::frame_id(*this)); }
+
+        AsyncGenerator get_return_object() {
+            auto h = std::coroutine_handle<promise_type>::from_promise(*this);
+            COROUTINE_TRACE_CREATE("AsyncGenerator", h.address());
+            return AsyncGenerator{h};
+        }
+
+        std::stop_token get_stop_token() const noexcept { return stop_token; }
+
+        COROUTINE_TRACE_AWAIT
+
+        // Hands control back to the consumer waiting for an element
+        struct YieldAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                COROUTINE_TRACE_SUSPEND("yield", h.address());
+                COROUTINE_TRACE_RESUME(h.promise().consumer.address());
+                return h.promise().consumer;
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() { return {}; }
+        YieldAwaiter final_suspend() noexcept { return {}; }
+
+        YieldAwaiter yield_value(reference value) noexcept {
+            current = std::addressof(value);
+            movable = false;
+            return {};
+        }
+
+        // A temporary lives until the end of the co_yield expression, which
+        // spans the whole suspension
+        YieldAwaiter yield_value(value_type&& value) noexcept
+            requires(!std::is_reference_v<T>)
+        {
+            current = std::addressof(value);
+            movable = true;
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+    };
+
+    class Iterator;
+
+    // Resumes the producer until its next co_yield or its end. co_await
+    // gives true if there is a new element.
+    class NextAwaiter {
+    public:
+        explicit NextAwaiter(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+        bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> consumer) noexcept {
+            auto& promise = handle_.promise();
+            promise.consumer = consumer;
+            if (!promise.started) {
+                promise.started = true;
+                promise.stop_token = detail::stop_token_of(consumer);
+            }
+            COROUTINE_TRACE_SUSPEND("next", consumer.address());
+            COROUTINE_TRACE_RESUME(handle_.address());
+            return handle_;
+        }
+
+        bool await_resume() const {
+            if (!handle_) return false;
+            if (handle_.promise().exception) {
+                std::rethrow_exception(handle_.promise().exception);
+            }
+            return !handle_.done();
+        }
+
+    protected:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    // co_await gives an iterator at the first element
+    class BeginAwaiter : public NextAwaiter {
+    public:
+        using NextAwaiter::NextAwaiter;
+
+        Iterator await_resume() const {
+            NextAwaiter::await_resume();
+            return Iterator{this->handle_};
+        }
+    };
+
+    // co_await gives the iterator, advanced
+    class IncrementAwaiter : public NextAwaiter {
+    public:
+        explicit IncrementAwaiter(Iterator& it) : NextAwaiter(it.handle_), it_(&it) {}
+
+        Iterator& await_resume() const {
+            NextAwaiter::await_resume();
+            return *it_;
+        }
+
+    private:
+        Iterator* it_;
+    };
+
+    class Iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = AsyncGenerator::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        explicit Iterator(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+        reference operator*() const {
+            return static_cast<reference>(*handle_.promise().current);
+        }
+
+        // Must be awaited: co_await ++it
+        [[nodiscard]] IncrementAwaiter operator++() { return IncrementAwaiter{*this}; }
+
+        friend bool operator==(const Iterator& it, std::default_sentinel_t) noexcept {
+            return !it.handle_ || it.handle_.done();
+        }
+
+    private:
+        friend class IncrementAwaiter;
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    AsyncGenerator() = default;
+    explicit AsyncGenerator(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+    ~AsyncGenerator() {
+        if (handle_) handle_.destroy();
+    }
+
+    // Move-only type
+    AsyncGenerator(const AsyncGenerator&) = delete;
+    AsyncGenerator& operator=(const AsyncGenerator&) = delete;
+
+    AsyncGenerator(AsyncGenerator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    AsyncGenerator& operator=(AsyncGenerator&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    [[nodiscard]] NextAwaiter next() noexcept { return NextAwaiter{handle_}; }
+
+    // The element produced by the last next(); valid until the next one
+    reference value() const {
+        return static_cast<reference>(*handle_.promise().current);
+    }
+
+    // Moves the current value out when it was yielded as an rvalue
+    value_type take() const
+        requires(!std::is_reference_v<T>)
+    {
+        auto& promise = handle_.promise();
+        if (promise.movable) {
+            return std::move(*const_cast<value_type*>(promise.current));
+        }
+        return *promise.current;
+    }
+
+    // Runs the producer up to its first co_yield. There is only one pass
+    // over the sequence.
+    [[nodiscard]] BeginAwaiter begin() noexcept { return BeginAwaiter{handle_}; }
+
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "handoff.h"
+
+// ============================================================================
+// AsyncLatch / AsyncBarrier - One-shot and cyclic rendezvous for coroutines
+// ============================================================================
+//
+//   AsyncLatch ready(workers);
+//   ready.count_down();                 // In each worker
+//   co_await ready.wait();              // Resumes once the count hits zero
+//
+//   AsyncBarrier phase(workers, [] noexcept { swap_buffers(); });
+//   for (int step = 0; step < steps; ++step) {
+//       compute(step);
+//       co_await phase.arrive_and_wait();   // The callback runs once per phase,
+//   }                                       // before anyone continues
+//
+// Both keep their waiters on a lock-free stack of awaiters, so waiting
+// allocates nothing and nothing takes a lock. Waiters are released in
+// arrival order and resumed on the thread that completed the count (see
+// handoff.h).
+
+namespace detail {
+
+// Treiber stack of parked awaiters that can be closed: once `closed` is
+// stored, push() fails and the caller must not suspend
+class WaiterStack {
+public:
+    bool push(Waiter* waiter, std::uintptr_t closed) noexcept {
+        std::uintptr_t top = top_.load(std::memory_order_acquire);
+        do {
+            if (top == closed) return false;
+            waiter->next = reinterpret_cast<Waiter*>(top);
+        } while (!top_.compare_exchange_weak(top, reinterpret_cast<std::uintptr_t>(waiter),
+                                             std::memory_order_acq_rel, std::memory_order_acquire));
+        return true;
+    }
+
+    // Empties the stack (leaving `replacement` in its place) and returns
+    // the waiters in arrival order
+    Waiter* take(std::uintptr_t replacement) noexcept {
+        auto* stack = reinterpret_cast<Waiter*>(top_.exchange(replacement, std::memory_order_acq_rel));
+        Waiter* ordered = nullptr;
+        while (stack) {
+            Waiter* below = stack->next;
+            stack->next = ordered;
+            ordered = stack;
+            stack = below;
+        }
+        return ordered;
+    }
+
+    bool is(std::uintptr_t value) const noexcept { return top_.load(std::memory_order_acquire) == value; }
+
+private:
+    std::atomic<std::uintptr_t> top_{0};
+};
+
+inline void resume_all(Waiter* ordered) noexcept {
+    Waiter* last = ordered;
+    while (last && last->next) last = last->next;
+    HandoffQueue::resume(ordered, last);
+}
+
+}  // namespace detail
+
+class AsyncLatch {
+public:
+    explicit AsyncLatch(std::ptrdiff_t expected) : count_(expected) {
+        if (expected <= 0) waiters_.take(released);
+    }
+
+    AsyncLatch(const AsyncLatch&) = delete;
+    AsyncLatch& operator=(const AsyncLatch&) = delete;
+
+    class WaitAwaiter : public detail::Waiter {
+    public:
+        explicit WaitAwaiter(AsyncLatch& latch) : latch_(&latch) {}
+
+        bool await_ready() const noexcept { return latch_->try_wait(); }
+
+        bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            this->handle = handle;
+            return latch_->waiters_.push(this, released);
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        AsyncLatch* latch_;
+    };
+
+    // The call that takes the count to zero resumes every waiter
+    void count_down(std::ptrdiff_t n = 1) noexcept {
+        if (count_.fetch_sub(n, std::memory_order_acq_rel) == n) {
+            detail::resume_all(waiters_.take(released));
+        }
+    }
+
+    bool try_wait() const noexcept { return waiters_.is(released); }
+
+    [[nodiscard]] WaitAwaiter wait() noexcept { return WaitAwaiter{*this}; }
+
+    // count_down(n) followed by wait()
+    [[nodiscard]] WaitAwaiter arrive_and_wait(std::ptrdiff_t n = 1) noexcept {
+        count_down(n);
+        return WaitAwaiter{*this};
+    }
+
+private:
+    static constexpr std::uintptr_t released = 1;
+
+    std::atomic<std::ptrdiff_t> count_;
+    detail::WaiterStack waiters_;
+};
+
+struct NoBarrierCompletion {
+    void operator()() noexcept {}
+};
+
+// Like std::barrier: `expected` participants arrive once per phase. The
+// last to arrive runs `completion`, then everyone continues and the barrier
+// resets for the next phase.
+template<typename Completion = NoBarrierCompletion>
+class AsyncBarrier {
+    static_assert(std::is_nothrow_invocable_v<Completion&>, "the barrier completion must be noexcept");
+
+public:
+    explicit AsyncBarrier(std::ptrdiff_t expected, Completion completion = Completion())
+        : expected_(expected), remaining_(expected), completion_(std::move(completion)) {}
+
+    AsyncBarrier(const AsyncBarrier&) = delete;
+    AsyncBarrier& operator=(const AsyncBarrier&) = delete;
+
+    class ArriveAwaiter : public detail::Waiter {
+    public:
+        explicit ArriveAwaiter(AsyncBarrier& barrier) : barrier_(&barrier) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        // Parks first and only then counts the arrival, so the last
+        // arriver always finds everyone else on the stack
+        bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            this->handle = handle;
+            barrier_->waiters_.push(this, closed);
+            if (!barrier_->arrive()) return true;
+
+            // Last to arrive: continue without suspending
+            detail::Waiter* others = barrier_->finish_phase(this);
+            detail::resume_all(others);
+            return false;
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        AsyncBarrier* barrier_;
+    };
+
+    [[nodiscard]] ArriveAwaiter arrive_and_wait() noexcept { return ArriveAwaiter{*this}; }
+
+    // Arrives for the current phase and leaves: later phases expect one
+    // participant fewer
+    void arrive_and_drop() noexcept {
+        expected_.fetch_sub(1, std::memory_order_relaxed);
+        if (arrive()) detail::resume_all(finish_phase(nullptr));
+    }
+
+private:
+    static constexpr std::uintptr_t closed = 1;  // Never stored; the stack is reused every phase
+
+    // True for the arrival that completes the phase
+    bool arrive() noexcept { return remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+    // Runs the completion and resets for the next phase. Returns the
+    // parked waiters, minus `self`, in arrival order.
+    detail::Waiter* finish_phase(detail::Waiter* self) noexcept {
+        detail::Waiter* waiters = waiters_.take(0);
+        completion_();
+        // Nobody can arrive for the next phase before they are resumed
+        remaining_.store(expected_.load(std::memory_order_relaxed), std::memory_order_release);
+
+        detail::Waiter** link = &waiters;
+        while (*link && *link != self) link = &(*link)->next;
+        if (*link) *link = self->next;
+        return waiters;
+    }
+
+    std::atomic<std::ptrdiff_t> expected_;
+    std::atomic<std::ptrdiff_t> remaining_;
+    detail::WaiterStack waiters_;
+    [[no_unique_address]] Completion completion_;
+};
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+
+#include "handoff.h"
+
+// ============================================================================
+// AsyncMutex - Mutual exclusion that suspends the coroutine, not the thread
+// ============================================================================
+//
+//   AsyncMutex mutex;
+//   {
+//       auto lock = co_await mutex.scoped_lock();   // std::unique_lock<AsyncMutex>
+//       ...
+//   }                                               // unlock() on scope exit
+//
+// The whole state is one atomic word: unlocked, locked, or locked with a
+// stack of coroutines that arrived while it was held. Locking an unlocked
+// mutex is a single CAS. A contended lock() pushes its awaiter onto the
+// stack, so waiting allocates nothing.
+//
+// unlock() never lets the mutex go free while someone waits. It takes the
+// oldest waiter, makes it the owner, and resumes it on the unlocking thread
+// (see handoff.h). Waiters get the lock in arrival order: the owner moves
+// newly arrived waiters off the stack into a FIFO list it alone touches,
+// and serves that list before looking at the stack again.
+
+class AsyncMutex {
+public:
+    AsyncMutex() = default;
+    AsyncMutex(const AsyncMutex&) = delete;
+    AsyncMutex& operator=(const AsyncMutex&) = delete;
+
+    class LockAwaiter : public detail::Waiter {
+    public:
+        explicit LockAwaiter(AsyncMutex& mutex) : mutex_(&mutex) {}
+
+        bool await_ready() noexcept { return mutex_->try_lock(); }
+
+        bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            this->handle = handle;
+            std::uintptr_t state = mutex_->state_.load(std::memory_order_relaxed);
+            while (true) {
+                if (state == not_locked) {
+                    if (mutex_->state_.compare_exchange_weak(state, locked_no_waiters, std::memory_order_acquire,
+                                                             std::memory_order_relaxed)) {
+                        return false;
+                    }
+                } else {
+                    this->next = reinterpret_cast<detail::Waiter*>(state);
+                    if (mutex_->state_.compare_exchange_weak(state, reinterpret_cast<std::uintptr_t>(this),
+                                                             std::memory_order_release, std::memory_order_relaxed)) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        void await_resume() const noexcept {}
+
+    protected:
+        AsyncMutex* mutex_;
+    };
+
+    class ScopedLockAwaiter : public LockAwaiter {
+    public:
+        using LockAwaiter::LockAwaiter;
+
+        [[nodiscard]] std::unique_lock<AsyncMutex> await_resume() const noexcept {
+            return std::unique_lock<AsyncMutex>(*mutex_, std::adopt_lock);
+        }
+    };
+
+    // co_await mutex.lock(); ... mutex.unlock();
+    [[nodiscard]] LockAwaiter lock() noexcept { return LockAwaiter{*this}; }
+
+    // co_await gives a std::unique_lock that unlocks when it goes out of scope
+    [[nodiscard]] ScopedLockAwaiter scoped_lock() noexcept { return ScopedLockAwaiter{*this}; }
+
+    bool try_lock() noexcept {
+        std::uintptr_t expected = not_locked;
+        return state_.compare_exchange_strong(expected, locked_no_waiters, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    // Owner only. Resumes the next waiter, if any, before returning.
+    void unlock() noexcept {
+        detail::Waiter* next = waiters_;
+        if (!next) {
+            std::uintptr_t expected = locked_no_waiters;
+            if (state_.compare_exchange_strong(expected, not_locked, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+                return;
+            }
+
+            // Take everyone who arrived since the last unlock and reverse
+            // the stack into arrival order
+            auto* stack = reinterpret_cast<detail::Waiter*>(
+                state_.exchange(locked_no_waiters, std::memory_order_acquire));
+            while (stack) {
+                detail::Waiter* below = stack->next;
+                stack->next = next;
+                next = stack;
+                stack = below;
+            }
+        }
+        waiters_ = next->next;
+        detail::HandoffQueue::resume(next);
+    }
+
+private:
+    // Any other value is the most recently arrived waiter, with the mutex locked
+    static constexpr std::uintptr_t not_locked = 1;
+    static constexpr std::uintptr_t locked_no_waiters = 0;
+
+    std::atomic<std::uintptr_t> state_{not_locked};
+    detail::Waiter* waiters_ = nullptr;  // Arrival order; touched by the owner only
+};
+
+// ============================================================================
+// AsyncSharedMutex - Reader-writer lock for coroutines
+// ============================================================================
+//
+//   co_await rw.lock_shared();  ...  rw.unlock_shared();
+//   auto lock = co_await rw.scoped_lock();   // std::unique_lock, exclusive
+//
+// One atomic word holds the writer bit, a "someone is parked" bit and the
+// reader count. While nobody is parked, lock, lock_shared and both unlocks
+// are a single CAS or fetch_sub.
+//
+// A coroutine that cannot get the lock parks itself on a FIFO list guarded
+// by a std::mutex, which only contended paths take. While anyone is parked,
+// new readers queue too, so a steady stream of readers cannot starve a
+// writer. When the last holder leaves it hands the lock to the head of the
+// list: one writer, or every reader up to the next writer. Resumed waiters
+// run on the releasing thread (see handoff.h).
+
+class AsyncSharedMutex {
+public:
+    AsyncSharedMutex() = default;
+    AsyncSharedMutex(const AsyncSharedMutex&) = delete;
+    AsyncSharedMutex& operator=(const AsyncSharedMutex&) = delete;
+
+    class LockAwaiter : public detail::Waiter {
+    public:
+        LockAwaiter(AsyncSharedMutex& mutex, bool shared) : mutex_(&mutex), shared_(shared) {}
+
+        bool await_ready() noexcept { return shared_ ? mutex_->try_lock_shared() : mutex_->try_lock(); }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            this->handle = handle;
+            return mutex_->park(this);
+        }
+
+        void await_resume() const noexcept {}
+
+    protected:
+        friend class AsyncSharedMutex;
+
+        AsyncSharedMutex* mutex_;
+        bool shared_;
+    };
+
+    class ScopedLockAwaiter : public LockAwaiter {
+    public:
+        explicit ScopedLockAwaiter(AsyncSharedMutex& mutex) : LockAwaiter(mutex, false) {}
+
+        [[nodiscard]] std::unique_lock<AsyncSharedMutex> await_resume() const noexcept {
+            return std::unique_lock<AsyncSharedMutex>(*mutex_, std::adopt_lock);
+        }
+    };
+
+    class ScopedSharedLockAwaiter : public LockAwaiter {
+    public:
+        explicit ScopedSharedLockAwaiter(AsyncSharedMutex& mutex) : LockAwaiter(mutex, true) {}
+
+        [[nodiscard]] std::shared_lock<AsyncSharedMutex> await_resume() const noexcept {
+            return std::shared_lock<AsyncSharedMutex>(*mutex_, std::adopt_lock);
+        }
+    };
+
+    [[nodiscard]] LockAwaiter lock() noexcept { return LockAwaiter{*this, false}; }
+    [[nodiscard]] LockAwaiter lock_shared() noexcept { return LockAwaiter{*this, true}; }
+    [[nodiscard]] ScopedLockAwaiter scoped_lock() noexcept { return ScopedLockAwaiter{*this}; }
+    [[nodiscard]] ScopedSharedLockAwaiter scoped_lock_shared() noexcept { return ScopedSharedLockAwaiter{*this}; }
+
+    bool try_lock() noexcept {
+        std::uint64_t expected = 0;
+        return state_.compare_exchange_strong(expected, writer, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    bool try_lock_shared() noexcept {
+        std::uint64_t state = state_.load(std::memory_order_relaxed);
+        while (!(state & (writer | parked))) {
+            if (state_.compare_exchange_weak(state, state + reader, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void unlock() {
+        std::uint64_t expected = writer;
+        if (state_.compare_exchange_strong(expected, 0, std::memory_order_release, std::memory_order_relaxed)) {
+            return;
+        }
+        std::unique_lock lock(mutex_);
+        state_.fetch_and(~writer, std::memory_order_release);
+        hand_off(lock);
+    }
+
+    void unlock_shared() {
+        if (state_.fetch_sub(reader, std::memory_order_release) != (reader | parked)) return;
+        std::unique_lock lock(mutex_);
+        hand_off(lock);
+    }
+
+private:
+    static constexpr std::uint64_t writer = 1;
+    static constexpr std::uint64_t parked = 2;
+    static constexpr std::uint64_t reader = 4;  // Readers are counted in units of this
+
+    // Last try before suspending, made under the list lock after announcing
+    // ourselves with the parked bit: from here on every release that sees
+    // the bit comes through hand_off, so either this attempt sees the lock
+    // free or a hand_off will see us on the list. Returns false if the lock
+    // was taken after all.
+    bool park(LockAwaiter* waiter) {
+        std::lock_guard lock(mutex_);
+        std::uint64_t state = state_.fetch_or(parked, std::memory_order_acquire) | parked;
+        if (!head_) {
+            // Nobody ahead of us, so taking the lock does not jump the queue
+            const std::uint64_t busy = waiter->shared_ ? writer : ~parked;
+            while (!(state & busy)) {
+                std::uint64_t taken = (waiter->shared_ ? state + reader : state | writer) & ~parked;
+                if (state_.compare_exchange_weak(state, taken, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+                    return false;
+                }
+            }
+        }
+        waiter->next = nullptr;
+        if (tail_) {
+            tail_->next = waiter;
+        } else {
+            head_ = waiter;
+        }
+        tail_ = waiter;
+        return true;
+    }
+
+    // Called with the list lock held, once the lock may be free. Grants it
+    // to the head of the list if that is possible now; otherwise whoever
+    // holds it will call again on release.
+    void hand_off(std::unique_lock<std::mutex>& lock) {
+        auto* first = static_cast<LockAwaiter*>(head_);
+        if (!first) {
+            state_.fetch_and(~parked, std::memory_order_relaxed);
+            return;
+        }
+
+        std::uint64_t state = state_.load(std::memory_order_acquire);
+        LockAwaiter* last = first;
+        if (!first->shared_) {
+            if (state != parked) return;  // Still held
+        } else {
+            if (state & writer) return;
+            std::uint64_t readers = reader;
+            while (last->next && static_cast<LockAwaiter*>(last->next)->shared_) {
+                last = static_cast<LockAwaiter*>(last->next);
+                readers += reader;
+            }
+            state = readers;
+        }
+
+        head_ = last->next;
+        if (!head_) tail_ = nullptr;
+        if (!first->shared_) state = writer;
+        // Readers cannot have come or gone meanwhile: the parked bit keeps
+        // new ones on the slow path and the count was zero or only ours
+        state_.fetch_add(state - (head_ ? 0 : parked), std::memory_order_acquire);
+
+        lock.unlock();
+        detail::HandoffQueue::resume(first, last);
+    }
+
+    std::atomic<std::uint64_t> state_{0};
+    std::mutex mutex_;
+    detail::Waiter* head_ = nullptr;  // Parked awaiters in arrival order; guarded by mutex_
+    detail::Waiter* tail_ = nullptr;
+};
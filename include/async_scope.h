@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <stdexcept>
+#include <stop_token>
+#include <utility>
+
+#include "cancellation.h"
+#include "frame_allocator.h"
+
+// ============================================================================
+// AsyncScope - Spawn tasks into a scope, then wait for all of them
+// ============================================================================
+//
+//   AsyncScope scope;
+//   for (auto& request : requests) {
+//       scope.spawn(handle(request));   // Task, LazyTask or any awaitable
+//   }
+//   co_await scope.join();              // Every spawned task has finished
+//
+// Each spawned task is moved into a small child coroutine that awaits it
+// and frees its own frame when done, so finished work is reclaimed right
+// away rather than when the scope ends. Unlike when_all, results are
+// discarded and tasks can be added at any time before the join completes:
+// before join() is awaited, or from a task already in the scope, which
+// keeps the join waiting. Spawning from elsewhere while a join is pending
+// races with the last child finishing. Once the count has reached zero
+// spawn() throws std::logic_error rather than start a task the resumed
+// joiner would never wait for.
+//
+// Outstanding children are counted on one atomic, which starts with one
+// extra reference held by the scope itself. join() drops that reference;
+// whichever of join() and the last child brings the count to zero resumes
+// the joining coroutine, the child by symmetric transfer.
+//
+// Children run with the scope's stop token (see cancellation.h), so
+// request_stop() asks all of them to finish early. If a task throws, join()
+// rethrows the first exception. A scope can be joined again after more
+// spawns; destroy it only after a join has completed.
+
+class AsyncScope;
+
+namespace detail {
+
+struct ScopeChild {
+    struct promise_type : PooledFramePromise {
+        AsyncScope* scope;
+
+        template<typename Awaitable>
+        promise_type(AsyncScope& s, Awaitable&) : scope(&s) {}
+
+        ScopeChild get_return_object() { return {}; }
+
+        std::stop_token get_stop_token() const noexcept;
+
+        // Frees the frame, then resumes the joiner if this was the last child
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_never initial_suspend() { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception();
+    };
+};
+
+template<typename Awaitable>
+ScopeChild run_scope_child(AsyncScope&, Awaitable awaitable) {
+    // The promise picks up the scope from the parameters
+    co_await std::move(awaitable);
+}
+
+}  // namespace detail
+
+class AsyncScope {
+public:
+    AsyncScope() = default;
+    AsyncScope(const AsyncScope&) = delete;
+    AsyncScope& operator=(const AsyncScope&) = delete;
+
+    class JoinAwaiter {
+    public:
+        explicit JoinAwaiter(AsyncScope& scope) : scope_(&scope) {}
+
+        bool await_ready() const noexcept { return scope_->count_.load(std::memory_order_acquire) == 1; }
+
+        bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            scope_->continuation_ = handle;
+            return scope_->count_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+        }
+
+        // Takes the scope's reference back, so it can be joined again
+        void await_resume() {
+            if (scope_->count_.load(std::memory_order_relaxed) == 0) {
+                scope_->count_.store(1, std::memory_order_relaxed);
+            }
+            if (scope_->exception_) {
+                scope_->failed_.store(false, std::memory_order_relaxed);
+                std::rethrow_exception(std::exchange(scope_->exception_, nullptr));
+            }
+        }
+
+    private:
+        AsyncScope* scope_;
+    };
+
+    // Starts awaiting `awaitable` in the scope. A Task is already running;
+    // a LazyTask starts here, on the calling thread. Throws
+    // std::logic_error if a pending join has already completed.
+    template<typename Awaitable>
+    void spawn(Awaitable awaitable) {
+        std::size_t count = count_.load(std::memory_order_relaxed);
+        do {
+            if (count == 0) throw std::logic_error("AsyncScope::spawn after the join completed");
+        } while (!count_.compare_exchange_weak(count, count + 1, std::memory_order_relaxed));
+        detail::run_scope_child(*this, std::move(awaitable));
+    }
+
+    // Resumes once every spawned task has finished
+    [[nodiscard]] JoinAwaiter join() noexcept { return JoinAwaiter{*this}; }
+
+    // Asks the spawned tasks to stop through their stop token
+    bool request_stop() noexcept { return stop_.request_stop(); }
+
+    std::stop_token get_stop_token() const noexcept { return stop_.get_token(); }
+
+    // Spawned tasks that have not finished yet
+    std::size_t pending() const noexcept {
+        std::size_t count = count_.load(std::memory_order_relaxed);
+        return count == 0 ? 0 : count - 1;
+    }
+
+private:
+    friend struct detail::ScopeChild::promise_type;
+
+    std::coroutine_handle<> child_finished() noexcept {
+        if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) return continuation_;
+        return std::noop_coroutine();
+    }
+
+    void child_failed(std::exception_ptr exception) noexcept {
+        if (!failed_.exchange(true, std::memory_order_relaxed)) exception_ = std::move(exception);
+    }
+
+    std::atomic<std::size_t> count_{1};  // Children plus the scope's own reference
+    std::coroutine_handle<> continuation_;
+    std::atomic<bool> failed_{false};
+    std::exception_ptr exception_;  // Published to the joiner by the count
+    std::stop_source stop_;
+};
+
+namespace detail {
+
+inline std::stop_token ScopeChild::promise_type::get_stop_token() const noexcept {
+    return scope->get_stop_token();
+}
+
+inline std::coroutine_handle<> ScopeChild::promise_type::FinalAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> h) noexcept {
+    AsyncScope* scope = h.promise().scope;
+    h.destroy();
+    return scope->child_finished();
+}
+
+inline void ScopeChild::promise_type::unhandled_exception() {
+    scope->child_failed(std::current_exception());
+}
+
+}  // namespace detail
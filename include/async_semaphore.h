@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+
+#include "handoff.h"
+
+// ============================================================================
+// AsyncSemaphore - Counting semaphore that suspends the coroutine
+// ============================================================================
+//
+//   AsyncSemaphore slots(8);            // At most 8 downloads at a time
+//   co_await slots.acquire();
+//   co_await download(url);
+//   slots.release();
+//
+// The count lives in one atomic. acquire() takes a unit with a fetch_sub
+// and release() returns one with a fetch_add. Neither takes a lock while
+// units are available. A negative count is the number of coroutines that
+// took a unit they did not get. They park on a FIFO list inside their own
+// awaiters, under a mutex that only the waiting paths use.
+//
+// A release() that finds the count negative owes someone a unit. It hands
+// the unit to the oldest parked waiter and resumes it on the releasing
+// thread (see handoff.h). The waiter may not have reached the list yet; in
+// that case the unit is left as a token, and the waiter takes it instead of
+// parking.
+
+class AsyncSemaphore {
+public:
+    explicit AsyncSemaphore(std::ptrdiff_t initial) : count_(initial) {}
+
+    AsyncSemaphore(const AsyncSemaphore&) = delete;
+    AsyncSemaphore& operator=(const AsyncSemaphore&) = delete;
+
+    class AcquireAwaiter : public detail::Waiter {
+    public:
+        explicit AcquireAwaiter(AsyncSemaphore& semaphore) : semaphore_(&semaphore) {}
+
+        bool await_ready() noexcept { return semaphore_->count_.fetch_sub(1, std::memory_order_acquire) > 0; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            this->handle = handle;
+            AsyncSemaphore& semaphore = *semaphore_;
+            std::lock_guard lock(semaphore.mutex_);
+            if (semaphore.tokens_ > 0) {
+                --semaphore.tokens_;
+                return false;
+            }
+            this->next = nullptr;
+            if (semaphore.tail_) {
+                semaphore.tail_->next = this;
+            } else {
+                semaphore.head_ = this;
+            }
+            semaphore.tail_ = this;
+            return true;
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        AsyncSemaphore* semaphore_;
+    };
+
+    [[nodiscard]] AcquireAwaiter acquire() noexcept { return AcquireAwaiter{*this}; }
+
+    bool try_acquire() noexcept {
+        std::ptrdiff_t count = count_.load(std::memory_order_relaxed);
+        while (count > 0) {
+            if (count_.compare_exchange_weak(count, count - 1, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void release(std::ptrdiff_t units = 1) {
+        std::ptrdiff_t before = count_.fetch_add(units, std::memory_order_release);
+        if (before >= 0) return;
+
+        std::ptrdiff_t owed = -before < units ? -before : units;
+        detail::Waiter* first = nullptr;
+        detail::Waiter* last = nullptr;
+        {
+            std::lock_guard lock(mutex_);
+            for (; owed > 0 && head_; --owed) {
+                detail::Waiter* waiter = head_;
+                head_ = waiter->next;
+                if (!head_) tail_ = nullptr;
+                if (last) {
+                    last->next = waiter;
+                } else {
+                    first = waiter;
+                }
+                last = waiter;
+            }
+            tokens_ += owed;  // For waiters that have not parked yet
+        }
+        detail::HandoffQueue::resume(first, last);
+    }
+
+    // Units available right now; negative when coroutines are waiting
+    std::ptrdiff_t available() const noexcept { return count_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::ptrdiff_t> count_;
+    std::mutex mutex_;
+    std::ptrdiff_t tokens_ = 0;       // Guarded by mutex_
+    detail::Waiter* head_ = nullptr;  // Parked awaiters in arrival order; guarded by mutex_
+    detail::Waiter* tail_ = nullptr;
+};
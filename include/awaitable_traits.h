@@ -0,0 +1,29 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+// ============================================================================
+// Awaitable traits - What does `co_await expr` produce?
+// ============================================================================
+
+namespace detail {
+
+// The awaiter co_await would use: the result of a member operator co_await
+// if there is one, otherwise the object itself
+template<typename Awaitable>
+decltype(auto) get_awaiter(Awaitable&& awaitable) {
+    if constexpr (requires { std::forward<Awaitable>(awaitable).operator co_await(); }) {
+        return std::forward<Awaitable>(awaitable).operator co_await();
+    } else {
+        return std::forward<Awaitable>(awaitable);
+    }
+}
+
+template<typename Awaitable>
+using awaiter_t = decltype(get_awaiter(std::declval<Awaitable>()));
+
+template<typename Awaitable>
+using await_result_t = decltype(std::declval<awaiter_t<Awaitable>&>().await_resume());
+
+}  // namespace detail
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "frame_allocator.h"
+#include "generator.h"
+#include "trace.h"
+
+// ============================================================================
+// BatchedGenerator - A generator that hands out its values a batch at a time
+// ============================================================================
+//
+//   BatchedGenerator<int> numbers(int end) {
+//       for (int i = 0; i < end; ++i) co_yield i;   // Same body as a Generator
+//   }
+//
+//   for (std::span<int> batch : numbers(1'000'000)) {
+//       for (int v : batch) sum += v;               // A plain loop the compiler can vectorize
+//   }
+//
+// co_yield copies (or moves) the value into a buffer inside the frame and
+// only suspends once the buffer holds BatchSize values. A co_yield that does
+// not fill the buffer costs a store and a compare; the resume and the
+// indirect call are paid once per batch instead of once per element. The
+// last batch may be shorter.
+//
+// `co_yield elements_of(range)` copies a whole range in. The copy runs in
+// an ordinary loop outside the coroutine body, and when the buffer fills up
+// in the middle of the range, the next batch is copied from where it left
+// off without resuming the coroutine at all. A producer that can express
+// its output as a range (std::views::iota, a slice of a vector) thus pays
+// per batch, not per element, on both sides.
+//
+// A batch is a std::span over the frame's buffer: the consumer may modify
+// or move from its elements, but must be done with them before asking for
+// the next batch. T must be default constructible.
+
+template<typename T, std::size_t BatchSize = 256>
+class BatchedGenerator : public std::ranges::view_base {
+    static_assert(BatchSize > 0, "a batch must hold at least one value");
+    static_assert(std::is_default_constructible_v<T>, "the batch buffer default-constructs its elements");
+
+public:
+    using value_type = T;
+
+    struct promise_type : PooledFramePromise {
+        std::array<T, BatchSize> buffer;
+        std::size_t size = 0;  // Values in the current batch
+        std::exception_ptr exception;
+
+        // Set while suspended in the middle of an elements_of range: copies
+        // the next batch from it, and returns true once the range is done
+        bool (*refill)(void* source) = nullptr;
+        void* source = nullptr;
+
+        ~promise_type() { COROUTINE_TRACE_DESTROY(trace::frame_id(*this)); }
+
+        BatchedGenerator get_return_object() {
+            auto h = std::coroutine_handle<promise_type>::from_promise(*this);
+            COROUTINE_TRACE_CREATE("BatchedGenerator", h.address());
+            return BatchedGenerator{h};
+        }
+
+        // Suspends only when the value just stored filled the batch
+        struct YieldAwaiter {
+            bool full;
+
+            bool await_ready() const noexcept { return !full; }
+            void await_suspend([[maybe_unused]] std::coroutine_handle<promise_type> h) const noexcept {
+                COROUTINE_TRACE_SUSPEND("batch", h.address());
+            }
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        YieldAwaiter yield_value(const T& value) noexcept(std::is_nothrow_copy_assignable_v<T>) {
+            buffer[size] = value;
+            return YieldAwaiter{++size == BatchSize};
+        }
+
+        YieldAwaiter yield_value(T&& value) noexcept(std::is_nothrow_move_assignable_v<T>) {
+            buffer[size] = std::move(value);
+            return YieldAwaiter{++size == BatchSize};
+        }
+
+        // Lives in the frame while suspended, so its iterators stay valid
+        template<typename R>
+        class RangeAwaiter {
+        public:
+            RangeAwaiter(promise_type& promise, R&& range) : promise_(&promise), range_(std::forward<R>(range)) {}
+
+            bool await_ready() {
+                it_ = std::ranges::begin(range_);
+                end_ = std::ranges::end(range_);
+                if (fill(this)) return promise_->size < BatchSize;
+                promise_->refill = &fill;
+                promise_->source = this;
+                return false;
+            }
+
+            void await_suspend([[maybe_unused]] std::coroutine_handle<promise_type> h) const noexcept {
+                COROUTINE_TRACE_SUSPEND("batch", h.address());
+            }
+
+            void await_resume() const noexcept {}
+
+        private:
+            static bool fill(void* self) {
+                auto& awaiter = *static_cast<RangeAwaiter*>(self);
+                // Locals, so stores into the buffer cannot alias the loop state
+                T* out = awaiter.promise_->buffer.data();
+                std::size_t size = awaiter.promise_->size;
+                auto it = std::move(awaiter.it_);
+                for (; size < BatchSize && it != awaiter.end_; ++size, ++it) {
+                    out[size] = *it;
+                }
+                awaiter.promise_->size = size;
+                awaiter.it_ = std::move(it);
+                return awaiter.it_ == awaiter.end_;
+            }
+
+            promise_type* promise_;
+            R range_;
+            std::ranges::iterator_t<std::remove_reference_t<R>> it_{};
+            std::ranges::sentinel_t<std::remove_reference_t<R>> end_{};
+        };
+
+        template<std::ranges::input_range R>
+        RangeAwaiter<R> yield_value(elements_of<R> elements) {
+            return RangeAwaiter<R>{*this, std::forward<R>(elements.range)};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+    };
+
+    BatchedGenerator() = default;
+    explicit BatchedGenerator(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+    ~BatchedGenerator() {
+        if (handle_) handle_.destroy();
+    }
+
+    // Move-only type
+    BatchedGenerator(const BatchedGenerator&) = delete;
+    BatchedGenerator& operator=(const BatchedGenerator&) = delete;
+
+    BatchedGenerator(BatchedGenerator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    BatchedGenerator& operator=(BatchedGenerator&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    // Runs the coroutine until it fills a batch or finishes. False once
+    // there are no values left.
+    bool next() {
+        advance(handle_);
+        return handle_ && handle_.promise().size > 0;
+    }
+
+    // The values produced by the last next(); valid until the next one
+    std::span<T> batch() const noexcept {
+        auto& promise = handle_.promise();
+        return {promise.buffer.data(), promise.size};
+    }
+
+    class Iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = std::span<T>;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        explicit Iterator(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+        std::span<T> operator*() const noexcept {
+            auto& promise = handle_.promise();
+            return {promise.buffer.data(), promise.size};
+        }
+
+        Iterator& operator++() {
+            advance(handle_);
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const Iterator& it, std::default_sentinel_t) noexcept {
+            return !it.handle_ || it.handle_.promise().size == 0;
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    // Produces the first batch. Call it once: there is only one pass over
+    // the sequence.
+    Iterator begin() {
+        advance(handle_);
+        return Iterator{handle_};
+    }
+
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    // Empties the buffer and refills it, from a pending elements_of range
+    // if there is one and otherwise by resuming the coroutine. A finished
+    // coroutine leaves it empty, which ends the sequence.
+    static void advance(std::coroutine_handle<promise_type> h) {
+        if (!h) return;
+        auto& promise = h.promise();
+        promise.size = 0;
+        if (h.done()) return;
+        if (promise.refill) {
+            if (!promise.refill(promise.source)) return;  // The batch is full
+            promise.refill = nullptr;
+            if (promise.size == BatchSize) return;
+        }
+        COROUTINE_TRACE_RESUME(h.address());
+        h.resume();
+        if (promise.exception) {
+            std::rethrow_exception(promise.exception);
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+static_assert(std::ranges::input_range<BatchedGenerator<int>>);
+static_assert(std::ranges::view<BatchedGenerator<int>>);
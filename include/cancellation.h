@@ -0,0 +1,65 @@
+#pragma once
+
+#include <coroutine>
+#include <stop_token>
+#include <utility>
+
+// ============================================================================
+// Cancellation - std::stop_token carried by the awaiting coroutine
+// ============================================================================
+//
+//   Task<int> fetch(std::stop_token token, Request request) { ... }
+//
+//   std::stop_source stop;
+//   Task<int> task = fetch(stop.get_token(), request);
+//   stop.request_stop();    // A pending sleep, read or recv resumes right away
+//
+// Task and LazyTask promises hold a stop token. A coroutine whose first
+// parameter is a std::stop_token takes it from there. A LazyTask that has
+// not started yet inherits the token of the coroutine that awaits it, and
+// so do tasks passed to when_all. when_any hands its tasks a token of its
+// own that is stopped as soon as the first one finishes, and also when the
+// awaiting coroutine's token is stopped.
+//
+// Cancellable awaiters look up the token through the handle passed to
+// await_suspend and register a std::stop_callback for as long as they are
+// suspended. A cancelled timer (see TimerService::Timer) never fires, and
+// the sleep awaiter in main.cpp then reports SleepStatus::cancelled.
+// Cancelled file and socket operations throw std::system_error with
+// ECANCELED. Awaiters that do not look for a token, and coroutines that
+// have none, are never interrupted.
+//
+// Stop callbacks run on the thread that calls request_stop(), so a
+// cancelled coroutine resumes on that thread.
+
+namespace detail {
+
+// The token of the coroutine behind `handle`, or an empty token if its
+// promise has none
+template<typename Promise>
+std::stop_token stop_token_of(std::coroutine_handle<Promise> handle) noexcept {
+    if constexpr (requires { handle.promise().get_stop_token(); }) {
+        return handle.promise().get_stop_token();
+    } else {
+        return {};
+    }
+}
+
+struct CurrentStopTokenAwaiter {
+    std::stop_token token;
+
+    bool await_ready() const noexcept { return false; }
+
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        token = stop_token_of(handle);
+        return false;
+    }
+
+    std::stop_token await_resume() noexcept { return std::move(token); }
+};
+
+}  // namespace detail
+
+// std::stop_token token = co_await current_stop_token();
+inline detail::CurrentStopTokenAwaiter current_stop_token() noexcept { return {}; }
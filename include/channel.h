@@ -0,0 +1,359 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "handoff.h"
+
+// ============================================================================
+// Channel - Bounded multi-producer multi-consumer queue for coroutines
+// ============================================================================
+//
+//   Channel<int> ch(64);
+//   co_await ch.send(42);                  // false once the channel is closed
+//   std::optional<int> v = co_await ch.recv();   // nullopt once closed and drained
+//
+// Values live in a fixed-size lock-free ring (Vyukov's bounded MPMC queue).
+// send() and recv() go through the ring without locking and without
+// suspending as long as it is neither full nor empty.
+//
+// Only a coroutine that finds the ring full (send) or empty (recv) takes
+// the channel mutex and parks itself. The awaiter is the list node, so
+// parking allocates nothing. Each side keeps an atomic count of parked
+// waiters. After a successful push, the sender checks whether any receiver
+// is parked, and after a successful pop the receiver checks for parked
+// senders. Only when there are waiters does either side take the mutex. It
+// then moves a value on the waiter's behalf (popping into a parked
+// receiver, or pushing a parked sender's value) and resumes it on the
+// current thread through the hand-off queue (see handoff.h). In a chain of
+// coroutines connected by small channels, each stage's send would
+// otherwise resume the next stage inside its own frame, so the stack would
+// grow with the length of the chain.
+//
+// A parker increments the count before its final attempt on the ring, and
+// the other side touches the ring before it reads the count (both separated
+// by seq_cst fences). So either the parker sees the value, or the other side
+// sees the parker.
+//
+// close() wakes every parked coroutine. Senders get false. Receivers still
+// drain values already in the ring, then get nullopt.
+
+template<typename T>
+class Channel {
+public:
+    // Capacity is rounded up to a power of two
+    explicit Channel(std::size_t capacity)
+        : mask_(std::bit_ceil(capacity == 0 ? 1 : capacity) - 1), cells_(new Cell[mask_ + 1]) {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(2 * i, std::memory_order_relaxed);
+        }
+    }
+
+    ~Channel() {
+        std::optional<T> value;
+        while (try_pop(value)) value.reset();
+    }
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    class SendAwaiter;
+    class RecvAwaiter;
+
+    // co_await gives true once the value is in the channel, false if the
+    // channel was closed (the value is then dropped)
+    SendAwaiter send(T value) { return SendAwaiter{*this, std::move(value)}; }
+
+    // co_await gives the next value, or nullopt once the channel is closed
+    // and empty
+    RecvAwaiter recv() { return RecvAwaiter{*this}; }
+
+    // Non-suspending variants: false / nullopt when full / empty or closed
+    bool try_send(T value) {
+        if (closed_.load(std::memory_order_acquire) || !try_push(value)) return false;
+        after_push();
+        return true;
+    }
+
+    std::optional<T> try_recv() {
+        std::optional<T> value;
+        if (try_pop(value)) after_pop();
+        return value;
+    }
+
+    void close() {
+        Woken woken;
+        {
+            std::lock_guard lock(mutex_);
+            if (closed_.load(std::memory_order_relaxed)) return;
+            closed_.store(true, std::memory_order_release);
+
+            while (RecvAwaiter* receiver = receivers_.pop()) {
+                // A value may have arrived after the receiver parked
+                try_pop(receiver->result_);
+                woken.push(receiver);
+            }
+            while (SendAwaiter* sender = senders_.pop()) {
+                sender->sent_ = false;
+                woken.push(sender);
+            }
+            waiting_receivers_.store(0, std::memory_order_relaxed);
+            waiting_senders_.store(0, std::memory_order_relaxed);
+        }
+        woken.resume();
+    }
+
+    bool is_closed() const { return closed_.load(std::memory_order_acquire); }
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    // Waiters taken off the wait lists, in the order they were served
+    struct Woken {
+        detail::Waiter* first = nullptr;
+        detail::Waiter* last = nullptr;
+
+        void push(detail::Waiter* waiter) {
+            (last ? last->next : first) = waiter;
+            last = waiter;
+        }
+
+        // Outside the mutex: the resumed coroutines may use the channel
+        void resume() { detail::HandoffQueue::resume(first, last); }
+    };
+
+    // Intrusive FIFO of parked awaiters; guarded by mutex_
+    template<typename Node>
+    struct WaitList {
+        Node* head = nullptr;
+        Node* tail = nullptr;
+
+        void push(Node* node) {
+            node->next = nullptr;
+            if (tail) {
+                tail->next = node;
+            } else {
+                head = node;
+            }
+            tail = node;
+        }
+
+        Node* pop() {
+            Node* node = head;
+            if (node) {
+                head = static_cast<Node*>(node->next);
+                if (!head) tail = nullptr;
+            }
+            return node;
+        }
+
+        Node* front() const { return head; }
+    };
+
+public:
+    class SendAwaiter : public detail::Waiter {
+    public:
+        SendAwaiter(Channel& channel, T value) : channel_(&channel), value_(std::move(value)) {}
+
+        bool await_ready() {
+            if (channel_->closed_.load(std::memory_order_acquire)) {
+                sent_ = false;
+                return true;
+            }
+            if (!channel_->try_push(value_)) return false;
+            channel_->after_push();
+            return true;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            this->handle = handle;
+            Channel& channel = *channel_;
+            bool pushed;
+            {
+                std::lock_guard lock(channel.mutex_);
+                channel.waiting_senders_.fetch_add(1, std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                if (channel.closed_.load(std::memory_order_relaxed)) {
+                    sent_ = pushed = false;
+                } else if (channel.try_push(value_)) {
+                    pushed = true;
+                } else {
+                    channel.senders_.push(this);
+                    return true;
+                }
+                channel.waiting_senders_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (pushed) channel.after_push();
+            return false;
+        }
+
+        bool await_resume() const noexcept { return sent_; }
+
+    private:
+        friend class Channel;
+
+        Channel* channel_;
+        T value_;
+        bool sent_ = true;
+    };
+
+    class RecvAwaiter : public detail::Waiter {
+    public:
+        explicit RecvAwaiter(Channel& channel) : channel_(&channel) {}
+
+        bool await_ready() {
+            if (channel_->try_pop(result_)) {
+                channel_->after_pop();
+                return true;
+            }
+            // Closed: whatever was sent before close() is still delivered
+            if (channel_->closed_.load(std::memory_order_acquire)) {
+                channel_->try_pop(result_);
+                return true;
+            }
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            this->handle = handle;
+            Channel& channel = *channel_;
+            bool popped;
+            {
+                std::lock_guard lock(channel.mutex_);
+                channel.waiting_receivers_.fetch_add(1, std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                popped = channel.try_pop(result_);
+                if (!popped && !channel.closed_.load(std::memory_order_relaxed)) {
+                    channel.receivers_.push(this);
+                    return true;
+                }
+                channel.waiting_receivers_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (popped) channel.after_pop();
+            return false;
+        }
+
+        std::optional<T> await_resume() { return std::move(result_); }
+
+    private:
+        friend class Channel;
+
+        Channel* channel_;
+        std::optional<T> result_;
+    };
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        alignas(T) std::byte storage[sizeof(T)];
+
+        T* get() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    // Vyukov: a cell is free for the push at `pos` when its sequence is
+    // 2 * pos, and full for the pop at `pos` when it is 2 * pos + 1. (The
+    // original uses pos and pos + 1, which cannot tell "full" from "free
+    // again" when the ring has a single cell.) Moves from `value` only on
+    // success.
+    bool try_push(T& value) {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(2 * pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    ::new (static_cast<void*>(cell.storage)) T(std::move(value));
+                    cell.sequence.store(2 * pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(std::optional<T>& out) {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(2 * pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    T* item = cell.get();
+                    out.emplace(std::move(*item));
+                    item->~T();
+                    cell.sequence.store(2 * (pos + mask_ + 1), std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // The fast paths only pay for a fence and a load unless someone is parked
+    void after_push() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_receivers_.load(std::memory_order_relaxed) != 0) hand_off();
+    }
+
+    void after_pop() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting_senders_.load(std::memory_order_relaxed) != 0) hand_off();
+    }
+
+    // Serves parked waiters for as long as the ring lets us: every pop for
+    // a receiver frees a slot for a sender and every push for a sender
+    // fills one for a receiver
+    void hand_off() {
+        Woken woken;
+        {
+            std::lock_guard lock(mutex_);
+            bool progress = true;
+            while (progress) {
+                progress = false;
+                while (RecvAwaiter* receiver = receivers_.front()) {
+                    if (!try_pop(receiver->result_)) break;
+                    receivers_.pop();
+                    waiting_receivers_.fetch_sub(1, std::memory_order_relaxed);
+                    woken.push(receiver);
+                    progress = true;
+                }
+                while (SendAwaiter* sender = senders_.front()) {
+                    if (!try_push(sender->value_)) break;
+                    senders_.pop();
+                    waiting_senders_.fetch_sub(1, std::memory_order_relaxed);
+                    woken.push(sender);
+                    progress = true;
+                }
+            }
+        }
+        woken.resume();
+    }
+
+    const std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<std::size_t> dequeue_pos_{0};
+
+    alignas(64) std::atomic<std::size_t> waiting_senders_{0};
+    std::atomic<std::size_t> waiting_receivers_{0};
+    std::atomic<bool> closed_{false};
+    std::mutex mutex_;
+    WaitList<SendAwaiter> senders_;
+    WaitList<RecvAwaiter> receivers_;
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <ios>
+#include <iomanip>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "trace.h"
+
+// ============================================================================
+// Chrome trace export - View coroutine lifecycles in Perfetto
+// ============================================================================
+//
+// Writes trace events (see trace.h) in the Chrome trace-event JSON format,
+// which https://ui.perfetto.dev and chrome://tracing open directly:
+//
+//   std::ofstream out("coroutines.json");
+//   trace::write_chrome_trace(out, trace::snapshot());
+//
+// Each coroutine gets its own async track, labelled by its frame address.
+// On that track one slice covers the coroutine from create to destroy, and
+// "running" slices nested inside it cover each stretch from resume to
+// suspend. The gaps between them are the time it spent suspended. The same
+// running stretches also appear on the track of the thread that ran them,
+// so it is visible which coroutine held which thread.
+
+namespace trace {
+
+namespace detail {
+
+inline std::string coroutine_id(const void* coroutine) {
+    std::ostringstream id;
+    id << "0x" << std::hex << reinterpret_cast<std::uintptr_t>(coroutine);
+    return id.str();
+}
+
+inline std::string json_escaped(const char* text) {
+    std::string out;
+    for (const char* c = text ? text : ""; *c; ++c) {
+        if (*c == '"' || *c == '\\') out += '\\';
+        out += *c;
+    }
+    return out;
+}
+
+}  // namespace detail
+
+// `events` must be in time order, as trace::snapshot() returns them
+inline void write_chrome_trace(std::ostream& out, const std::vector<Event>& events) {
+    struct Live {
+        const char* name;
+        bool running;
+    };
+    std::unordered_map<const void*, Live> live;
+    std::set<std::uint32_t> threads;
+
+    const std::uint64_t origin = events.empty() ? 0 : events.front().time_ns;
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    bool first = true;
+    auto emit = [&](const char* phase, const std::string& name, const Event& event, bool async,
+                    const std::string& args) {
+        out << (first ? "\n" : ",\n") << "  {\"name\": \"" << name << "\", \"ph\": \"" << phase
+            << "\", \"ts\": " << static_cast<double>(event.time_ns - origin) / 1000.0
+            << ", \"pid\": 1, \"tid\": " << event.thread;
+        if (async) {
+            out << ", \"cat\": \"coroutine\", \"id\": \"" << detail::coroutine_id(event.coroutine) << "\"";
+        }
+        if (!args.empty()) out << ", \"args\": {" << args << "}";
+        out << "}";
+        first = false;
+    };
+
+    auto stop_running = [&](Live& state, const Event& event, const char* reason) {
+        if (!state.running) return;
+        std::string args = "\"reason\": \"" + detail::json_escaped(reason) + "\"";
+        emit("e", "running", event, true, args);
+        emit("E", "", event, false, "");
+        state.running = false;
+    };
+
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+    for (const Event& event : events) {
+        threads.insert(event.thread);
+        const std::string name = detail::json_escaped(event.name);
+
+        switch (event.kind) {
+        case Kind::instant:
+            if (event.coroutine) {
+                emit("n", name, event, true, "\"value\": " + std::to_string(event.value));
+            } else {
+                emit("i", name, event, false, "\"value\": " + std::to_string(event.value));
+            }
+            break;
+
+        case Kind::create: {
+            // A destroy lost to ring-buffer overflow leaves a stale entry
+            // for a reused frame address; close it first
+            if (auto it = live.find(event.coroutine); it != live.end()) {
+                stop_running(it->second, event, "lost");
+                emit("e", detail::json_escaped(it->second.name), event, true, "");
+            }
+            live[event.coroutine] = Live{event.name, false};
+            emit("b", name, event, true, "");
+            break;
+        }
+
+        case Kind::resume: {
+            // The create may have been overwritten in the ring buffer
+            auto [it, inserted] = live.try_emplace(event.coroutine, Live{"coroutine", false});
+            if (inserted) emit("b", "coroutine", event, true, "");
+            Live& state = it->second;
+            if (state.running) break;
+            state.running = true;
+            std::string label = detail::json_escaped(state.name) + " " + detail::coroutine_id(event.coroutine);
+            emit("b", "running", event, true, "\"thread\": " + std::to_string(event.thread));
+            emit("B", label, event, false, "");
+            break;
+        }
+
+        case Kind::suspend:
+            if (auto it = live.find(event.coroutine); it != live.end()) {
+                stop_running(it->second, event, event.name);
+            }
+            break;
+
+        case Kind::destroy:
+            if (auto it = live.find(event.coroutine); it != live.end()) {
+                stop_running(it->second, event, "destroy");
+                emit("e", detail::json_escaped(it->second.name), event, true, "");
+                live.erase(it);
+            }
+            break;
+        }
+    }
+
+    for (std::uint32_t thread : threads) {
+        out << (first ? "\n" : ",\n") << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << thread << ", \"args\": {\"name\": \"thread " << thread << "\"}}";
+        first = false;
+    }
+
+    out << "\n]}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+}  // namespace trace
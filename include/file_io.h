@@ -0,0 +1,785 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define COROUTINE_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#else
+#define COROUTINE_HAS_IO_URING 0
+#endif
+
+#include "cancellation.h"
+
+// ============================================================================
+// File I/O - co_await file.read(offset, buffer) on io_uring
+// ============================================================================
+//
+//   File file = File::open("data.bin", O_RDONLY);
+//   std::size_t n = co_await file.read(0, buffer);
+//
+// An IoService owns one reactor thread. Awaiting a read or write pushes the
+// operation onto a lock-free list and suspends. Each loop iteration, the
+// reactor moves everything queued since the last iteration into the
+// submission ring and makes one io_uring_enter call. That call submits the
+// whole batch and waits for completions, so thousands of in-flight reads
+// cost one system call per iteration rather than one each. New work wakes a
+// blocked reactor through an eventfd, and only the first operation of a
+// batch pays for that write.
+//
+// Buffers passed as IoOptions::fixed_buffers are registered with the
+// kernel once. An operation whose buffer lies inside one of them uses
+// READ_FIXED/WRITE_FIXED, which skips pinning the pages on every call.
+//
+// When io_uring is unavailable (non-Linux, a kernel older than 5.6, or a
+// container whose seccomp profile blocks it) the service falls back to a
+// small thread pool running pread/pwrite.
+//
+// Coroutines resume on the reactor thread (or a pool thread), just as
+// sleepers resume on the timer thread. Errors surface as std::system_error
+// from the co_await. Destroy an IoService only after its operations have
+// completed.
+//
+// A stop request on the awaiting coroutine's token (see cancellation.h)
+// cancels the operation: a queued one is dropped, and one already in the
+// kernel gets an IORING_OP_ASYNC_CANCEL. The co_await then throws
+// std::system_error with ECANCELED, unless the operation finished first. A
+// pool thread already inside pread/pwrite is not interrupted.
+
+enum class IoBackend { automatic, io_uring, threads };
+
+struct IoOptions {
+    unsigned entries = 256;  // Submission ring size; a power of two
+    std::vector<std::span<std::byte>> fixed_buffers;
+    IoBackend backend = IoBackend::automatic;
+    unsigned threads = 4;  // Thread-pool fallback only
+};
+
+namespace detail {
+
+struct IoOperation {
+    enum class Kind : std::uint8_t { read, write };
+    enum class Cancel : std::uint8_t { none, requested, completed };
+
+    IoOperation(Kind kind, int fd, std::uint64_t offset, std::byte* data, std::size_t size)
+        : kind(kind), fd(fd), offset(offset), data(data), size(size) {}
+
+    // Called once by the engine when the operation is done. The awaiter
+    // and the engine both arrive here; the second one resumes the waiter,
+    // so a completion racing with await_suspend is not resumed twice.
+    void finish() {
+        if (rendezvous.exchange(true, std::memory_order_acq_rel)) waiter.resume();
+    }
+
+    Kind kind;
+    int fd;
+    std::uint64_t offset;
+    std::byte* data;
+    std::size_t size;
+    int result = 0;  // Bytes transferred, or -errno
+    std::coroutine_handle<> waiter;
+    IoOperation* next = nullptr;
+    std::atomic<bool> rendezvous{false};
+
+    // io_uring engine: whichever of a stop request and the completion
+    // claims the operation first decides who finishes it
+    std::atomic<Cancel> cancel{Cancel::none};
+    IoOperation* cancel_next = nullptr;
+    bool cancel_handled = false;  // Reactor only
+    bool completed = false;       // Reactor only: the CQE came in while a cancel was pending
+};
+
+class IoEngine {
+public:
+    virtual ~IoEngine() = default;
+    virtual void submit(IoOperation* op) = 0;
+
+    // Asks for `op` to end early with -ECANCELED. `op` stays valid until
+    // this returns; it may still finish normally.
+    virtual void cancel(IoOperation* op) = 0;
+
+    std::atomic<std::uint64_t> operations{0};
+    std::atomic<std::uint64_t> system_calls{0};
+};
+
+// ----------------------------------------------------------------------------
+// Fallback: blocking pread/pwrite on a few threads
+// ----------------------------------------------------------------------------
+
+class ThreadPoolEngine final : public IoEngine {
+public:
+    explicit ThreadPoolEngine(unsigned threads) {
+        for (unsigned i = 0; i < std::max(threads, 1u); ++i) {
+            workers_.emplace_back([this] { run(); });
+        }
+    }
+
+    ~ThreadPoolEngine() override {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    void submit(IoOperation* op) override {
+        {
+            std::lock_guard lock(mutex_);
+            queue_.push_back(op);
+        }
+        wakeup_.notify_one();
+    }
+
+    // A queued operation is dropped; one a worker has taken runs to the end
+    void cancel(IoOperation* op) override {
+        {
+            std::lock_guard lock(mutex_);
+            auto it = std::find(queue_.begin(), queue_.end(), op);
+            if (it == queue_.end()) return;
+            queue_.erase(it);
+        }
+        op->result = -ECANCELED;
+        op->finish();
+    }
+
+private:
+    void run() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            wakeup_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+
+            IoOperation* op = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+
+            perform(*op);
+            operations.fetch_add(1, std::memory_order_relaxed);
+            system_calls.fetch_add(1, std::memory_order_relaxed);
+            op->finish();
+
+            lock.lock();
+        }
+    }
+
+    static void perform(IoOperation& op) {
+        ssize_t n;
+        do {
+            auto offset = static_cast<off_t>(op.offset);
+            n = op.kind == IoOperation::Kind::read ? ::pread(op.fd, op.data, op.size, offset)
+                                                   : ::pwrite(op.fd, op.data, op.size, offset);
+        } while (n < 0 && errno == EINTR);
+        op.result = n < 0 ? -errno : static_cast<int>(n);
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::deque<IoOperation*> queue_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+#if COROUTINE_HAS_IO_URING
+
+// ----------------------------------------------------------------------------
+// io_uring reactor, driven through the raw system calls
+// ----------------------------------------------------------------------------
+
+class UringEngine final : public IoEngine {
+public:
+    // Throws std::system_error when the kernel refuses or lacks io_uring
+    UringEngine(unsigned entries, const std::vector<std::span<std::byte>>& fixed_buffers) {
+        io_uring_params params{};
+        ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd_ < 0) throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+
+        try {
+            // IORING_OP_READ/WRITE arrived in 5.6, together with this flag
+            if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+                throw std::system_error(ENOSYS, std::generic_category(), "io_uring too old");
+            }
+            map_rings(params);
+            register_buffers(fixed_buffers);
+
+            event_fd_ = ::eventfd(0, EFD_CLOEXEC);
+            if (event_fd_ < 0) throw std::system_error(errno, std::generic_category(), "eventfd");
+        } catch (...) {
+            release();
+            throw;
+        }
+
+        reactor_ = std::thread([this] { run(); });
+    }
+
+    ~UringEngine() override {
+        stopping_.store(true, std::memory_order_release);
+        wake();
+        reactor_.join();
+        release();
+    }
+
+    void submit(IoOperation* op) override {
+        IoOperation* head = incoming_.load(std::memory_order_relaxed);
+        do {
+            op->next = head;
+        } while (!incoming_.compare_exchange_weak(head, op, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+
+        // Whoever makes the list non-empty wakes the reactor; later pushes
+        // join that batch. The reactor itself drains the list before it
+        // blocks again, so resumed coroutines submit for free.
+        if (!head && current_engine != this) wake();
+    }
+
+    void cancel(IoOperation* op) override {
+        auto expected = IoOperation::Cancel::none;
+        if (!op->cancel.compare_exchange_strong(expected, IoOperation::Cancel::requested,
+                                                std::memory_order_acq_rel)) {
+            return;  // Its completion is already being delivered
+        }
+
+        // From here on the reactor holds the completion back until it has
+        // seen this request
+        IoOperation* head = cancels_.load(std::memory_order_relaxed);
+        do {
+            op->cancel_next = head;
+        } while (!cancels_.compare_exchange_weak(head, op, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+        if (current_engine != this) wake();
+    }
+
+private:
+    static constexpr std::uint64_t wakeup_tag = 0;  // user_data of the eventfd read
+    static constexpr std::uint64_t cancel_tag = 1;  // user_data of IORING_OP_ASYNC_CANCEL
+
+    void map_rings(const io_uring_params& params) {
+        sq_entries_ = params.sq_entries;
+        cq_entries_ = params.cq_entries;
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+        sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_ = static_cast<io_uring_sqe*>(
+            map(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+
+        auto* sq = static_cast<std::byte*>(sq_ring_);
+        auto* cq = static_cast<std::byte*>(cq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void* map(std::size_t size, off_t offset) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+        if (p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "io_uring mmap");
+        return p;
+    }
+
+    // A low RLIMIT_MEMLOCK can refuse the registration; plain READ/WRITE
+    // still work then, so that is not an error
+    void register_buffers(const std::vector<std::span<std::byte>>& buffers) {
+        if (buffers.empty()) return;
+
+        std::vector<iovec> iovecs;
+        for (auto buffer : buffers) iovecs.push_back(iovec{buffer.data(), buffer.size()});
+        if (::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                      static_cast<unsigned>(iovecs.size())) < 0) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < buffers.size(); ++i) {
+            fixed_.push_back(FixedBuffer{buffers[i].data(), buffers[i].data() + buffers[i].size(),
+                                         static_cast<std::uint16_t>(i)});
+        }
+        std::sort(fixed_.begin(), fixed_.end(),
+                  [](const FixedBuffer& a, const FixedBuffer& b) { return a.begin < b.begin; });
+    }
+
+    // Index of the registered buffer that contains [data, data + size), or -1
+    int fixed_index(const std::byte* data, std::size_t size) const {
+        auto it = std::upper_bound(fixed_.begin(), fixed_.end(), data,
+                                   [](const std::byte* p, const FixedBuffer& b) { return p < b.begin; });
+        if (it == fixed_.begin()) return -1;
+        --it;
+        return data + size <= it->end ? it->index : -1;
+    }
+
+    void release() {
+        if (sqes_) ::munmap(sqes_, sq_entries_ * sizeof(io_uring_sqe));
+        if (cq_ring_ && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_) ::munmap(sq_ring_, sq_ring_size_);
+        if (ring_fd_ >= 0) ::close(ring_fd_);
+        if (event_fd_ >= 0) ::close(event_fd_);
+    }
+
+    void wake() {
+        system_calls.fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t one = 1;
+        [[maybe_unused]] auto written = ::write(event_fd_, &one, sizeof one);
+    }
+
+    // Only the reactor thread touches the submission ring; the kernel only
+    // consumes it inside io_uring_enter
+    io_uring_sqe* next_sqe() {
+        unsigned head = std::atomic_ref(*sq_head_).load(std::memory_order_acquire);
+        if (sq_tail_local_ - head >= sq_entries_) return nullptr;
+        unsigned index = sq_tail_local_ & sq_mask_;
+        sq_array_[index] = index;
+        ++sq_tail_local_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof *sqe);
+        return sqe;
+    }
+
+    bool prepare_wakeup_read() {
+        io_uring_sqe* sqe = next_sqe();
+        if (!sqe) return false;
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = event_fd_;
+        sqe->addr = reinterpret_cast<std::uint64_t>(&wakeup_value_);
+        sqe->len = sizeof wakeup_value_;
+        sqe->user_data = wakeup_tag;
+        return true;
+    }
+
+    bool prepare(IoOperation* op) {
+        io_uring_sqe* sqe = next_sqe();
+        if (!sqe) return false;
+
+        int fixed = fixed_index(op->data, op->size);
+        bool read = op->kind == IoOperation::Kind::read;
+        if (fixed >= 0) {
+            sqe->opcode = read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+            sqe->buf_index = static_cast<std::uint16_t>(fixed);
+        } else {
+            sqe->opcode = read ? IORING_OP_READ : IORING_OP_WRITE;
+        }
+        sqe->fd = op->fd;
+        sqe->off = op->offset;
+        sqe->addr = reinterpret_cast<std::uint64_t>(op->data);
+        sqe->len = static_cast<std::uint32_t>(std::min<std::size_t>(op->size, 1u << 30));
+        sqe->user_data = reinterpret_cast<std::uint64_t>(op);
+        return true;
+    }
+
+    bool prepare_cancel(IoOperation* op) {
+        io_uring_sqe* sqe = next_sqe();
+        if (!sqe) return false;
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = reinterpret_cast<std::uint64_t>(op);
+        sqe->user_data = cancel_tag;
+        return true;
+    }
+
+    // Handles the stop requests in `list`. Every operation in it was
+    // submitted before it was cancelled, and the list is taken before the
+    // incoming operations are moved to the backlog, so each one is in the
+    // backlog, in the kernel, or already completed.
+    void take_cancels(IoOperation* list, std::vector<IoOperation*>& ready) {
+        for (; list; list = list->cancel_next) {
+            list->cancel_handled = true;
+            if (list->completed) {
+                ready.push_back(list);
+                continue;
+            }
+            auto it = std::find(backlog_.begin(), backlog_.end(), list);
+            if (it != backlog_.end()) {
+                backlog_.erase(it);
+                list->result = -ECANCELED;
+                ready.push_back(list);
+            } else {
+                cancelling_.push_back(list);  // Its CQE follows the cancel
+            }
+        }
+    }
+
+    // Moves newly submitted operations to the back of `backlog_`, oldest first
+    void take_incoming() {
+        IoOperation* list = incoming_.exchange(nullptr, std::memory_order_acquire);
+        IoOperation* reversed = nullptr;
+        while (list) {
+            IoOperation* next = list->next;
+            list->next = reversed;
+            reversed = list;
+            list = next;
+        }
+        for (; reversed; reversed = reversed->next) backlog_.push_back(reversed);
+    }
+
+    void run() {
+        current_engine = this;
+        std::vector<IoOperation*> ready;
+        bool wakeup_armed = false;
+        unsigned in_flight = 0;  // Operations and cancels, not counting the wakeup read
+
+        while (true) {
+            IoOperation* cancels = cancels_.exchange(nullptr, std::memory_order_acquire);
+            take_incoming();
+            take_cancels(cancels, ready);
+
+            if (failed_) {
+                // Nothing more goes to the kernel
+                for (IoOperation* op : backlog_) {
+                    op->result = -failed_;
+                    ready.push_back(op);
+                }
+                backlog_.clear();
+                if (!ready.empty()) {
+                    finish(ready);
+                    continue;
+                }
+                if (stopping_.load(std::memory_order_acquire) && in_flight == 0) break;
+                wait_failed(in_flight > 0 || wakeup_armed);
+                reap(wakeup_armed, in_flight, ready);
+                finish(ready);
+                continue;
+            }
+
+            if (!wakeup_armed) wakeup_armed = prepare_wakeup_read();
+
+            // Stay within the completion ring so no completion is dropped
+            while (!cancelling_.empty() && in_flight + 1 < cq_entries_ && prepare_cancel(cancelling_.back())) {
+                cancelling_.pop_back();
+                ++in_flight;
+            }
+            while (!backlog_.empty() && in_flight + 1 < cq_entries_ && prepare(backlog_.front())) {
+                backlog_.pop_front();
+                ++in_flight;
+            }
+
+            // Operations dropped from the backlog need no system call
+            if (!ready.empty()) {
+                finish(ready);
+                continue;
+            }
+
+            if (stopping_.load(std::memory_order_acquire) && in_flight == 0 && backlog_.empty()) break;
+
+            unsigned to_submit = sq_tail_local_ - std::atomic_ref(*sq_head_).load(std::memory_order_acquire);
+            std::atomic_ref(*sq_tail_).store(sq_tail_local_, std::memory_order_release);
+
+            system_calls.fetch_add(1, std::memory_order_relaxed);
+            long entered = ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, 1u,
+                                     static_cast<unsigned>(IORING_ENTER_GETEVENTS), nullptr, std::size_t{0});
+            if (entered < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                // Throwing here would terminate the process. The engine
+                // stops using the ring and fails the operations instead.
+                failed_ = errno;
+                withdraw_unsubmitted(wakeup_armed, in_flight, ready);
+            }
+
+            reap(wakeup_armed, in_flight, ready);
+            finish(ready);
+        }
+    }
+
+    // Collects completions, hands the slots back to the kernel, and queues
+    // the operations to resume. Resuming comes after: the resumed
+    // coroutines may queue new operations.
+    void reap(bool& wakeup_armed, unsigned& in_flight, std::vector<IoOperation*>& ready) {
+        unsigned head = *cq_head_;
+        unsigned tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            if (cqe.user_data == wakeup_tag) {
+                wakeup_armed = false;
+                continue;
+            }
+            --in_flight;
+            if (cqe.user_data == cancel_tag) continue;  // The operation reports the outcome
+            complete(reinterpret_cast<IoOperation*>(cqe.user_data), cqe.res, ready);
+        }
+        std::atomic_ref(*cq_head_).store(head, std::memory_order_release);
+    }
+
+    void complete(IoOperation* op, int result, std::vector<IoOperation*>& ready) {
+        op->result = result;
+        auto expected = IoOperation::Cancel::none;
+        if (op->cancel.compare_exchange_strong(expected, IoOperation::Cancel::completed,
+                                               std::memory_order_acq_rel) ||
+            op->cancel_handled) {
+            if (op->cancel_handled) std::erase(cancelling_, op);
+            ready.push_back(op);
+        } else {
+            op->completed = true;  // Finished once its cancel request turns up
+        }
+    }
+
+    // After a failed io_uring_enter: entries the kernel has not consumed
+    // are taken back out of the ring, and their operations fail with the
+    // error. Operations the kernel already has are still reaped as their
+    // completions appear, so no buffer is released while it may be written.
+    void withdraw_unsubmitted(bool& wakeup_armed, unsigned& in_flight, std::vector<IoOperation*>& ready) {
+        unsigned head = std::atomic_ref(*sq_head_).load(std::memory_order_acquire);
+        for (unsigned i = head; i != sq_tail_local_; ++i) {
+            const io_uring_sqe& sqe = sqes_[i & sq_mask_];
+            if (sqe.user_data == wakeup_tag) {
+                wakeup_armed = false;
+                continue;
+            }
+            --in_flight;
+            // A withdrawn cancel leaves its operation to complete normally
+            if (sqe.user_data == cancel_tag) continue;
+            complete(reinterpret_cast<IoOperation*>(sqe.user_data), -failed_, ready);
+        }
+        sq_tail_local_ = head;
+        std::atomic_ref(*sq_tail_).store(head, std::memory_order_release);
+    }
+
+    // Waits for a wake() once the ring is no longer entered. While
+    // completions are still due, or the armed eventfd read may swallow a
+    // wake-up, it polls the completion ring every millisecond instead.
+    void wait_failed(bool completions_due) {
+        pollfd fd{event_fd_, POLLIN, 0};
+        if (::poll(&fd, 1, completions_due ? 1 : -1) > 0) {
+            std::uint64_t value;
+            [[maybe_unused]] auto read = ::read(event_fd_, &value, sizeof value);
+        }
+    }
+
+    // Resumes the waiters: they may queue new operations
+    void finish(std::vector<IoOperation*>& ready) {
+        operations.fetch_add(ready.size(), std::memory_order_relaxed);
+        for (auto* op : ready) op->finish();
+        ready.clear();
+    }
+
+    struct FixedBuffer {
+        const std::byte* begin;
+        const std::byte* end;
+        std::uint16_t index;
+    };
+
+    static inline thread_local const UringEngine* current_engine = nullptr;
+
+    int ring_fd_ = -1;
+    int event_fd_ = -1;
+    std::uint64_t wakeup_value_ = 0;
+
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    std::size_t sq_ring_size_ = 0;
+    std::size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned sq_entries_ = 0;
+    unsigned cq_entries_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_tail_local_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    std::vector<FixedBuffer> fixed_;
+    std::atomic<IoOperation*> incoming_{nullptr};
+    std::deque<IoOperation*> backlog_;  // Reactor only: waiting for ring space
+    std::atomic<IoOperation*> cancels_{nullptr};
+    std::vector<IoOperation*> cancelling_;  // Reactor only: in the kernel, async cancel not yet queued
+    std::atomic<bool> stopping_{false};
+    int failed_ = 0;  // Reactor only: errno of the io_uring_enter that failed
+    std::thread reactor_;  // Declared last: starts after the members it uses
+};
+
+#endif  // COROUTINE_HAS_IO_URING
+
+}  // namespace detail
+
+// ============================================================================
+// IoService - Owns the io_uring reactor (or the fallback pool)
+// ============================================================================
+
+class IoService {
+public:
+    explicit IoService(IoOptions options = {}) {
+#if COROUTINE_HAS_IO_URING
+        if (options.backend != IoBackend::threads) {
+            try {
+                engine_ = std::make_unique<detail::UringEngine>(options.entries, options.fixed_buffers);
+                backend_ = IoBackend::io_uring;
+                return;
+            } catch (const std::system_error&) {
+                if (options.backend == IoBackend::io_uring) throw;
+            }
+        }
+#else
+        if (options.backend == IoBackend::io_uring) {
+            throw std::system_error(ENOSYS, std::generic_category(), "io_uring");
+        }
+#endif
+        engine_ = std::make_unique<detail::ThreadPoolEngine>(options.threads);
+        backend_ = IoBackend::threads;
+    }
+
+    IoService(const IoService&) = delete;
+    IoService& operator=(const IoService&) = delete;
+
+    // Process-wide service used by File::open() by default
+    static IoService& instance() {
+        static IoService service;
+        return service;
+    }
+
+    // io_uring or threads: what `automatic` resolved to
+    IoBackend backend() const { return backend_; }
+
+    // Completed operations, and the system calls spent on them
+    std::uint64_t operations() const { return engine_->operations.load(std::memory_order_relaxed); }
+    std::uint64_t system_calls() const { return engine_->system_calls.load(std::memory_order_relaxed); }
+
+    void submit(detail::IoOperation* op) { engine_->submit(op); }
+    void cancel(detail::IoOperation* op) { engine_->cancel(op); }
+
+private:
+    std::unique_ptr<detail::IoEngine> engine_;
+    IoBackend backend_;
+};
+
+namespace detail {
+
+class IoAwaiter {
+public:
+    IoAwaiter(IoService& service, IoOperation::Kind kind, int fd, std::uint64_t offset, std::byte* data,
+              std::size_t size)
+        : service_(service), op_(kind, fd, offset, data, size) {}
+
+    bool await_ready() const noexcept { return op_.size == 0; }
+
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle) {
+        op_.waiter = handle;
+        std::stop_token token = stop_token_of(handle);
+        if (!token.stop_possible()) {
+            op_.rendezvous.store(true, std::memory_order_relaxed);  // The engine resumes us
+            service_.submit(&op_);
+            return true;
+        }
+        if (token.stop_requested()) {
+            op_.result = -ECANCELED;
+            return false;
+        }
+
+        // The callback can only cancel a submitted operation, so it is
+        // registered after submitting; the rendezvous in finish() covers a
+        // completion that beats us to the end of this function
+        service_.submit(&op_);
+        on_stop_.emplace(token, CancelOnStop{this});
+        return !op_.rendezvous.exchange(true, std::memory_order_acq_rel);
+    }
+
+    // Bytes transferred; may be short at end of file
+    std::size_t await_resume() {
+        on_stop_.reset();
+        if (op_.result < 0) {
+            bool read = op_.kind == IoOperation::Kind::read;
+            throw std::system_error(-op_.result, std::generic_category(), read ? "read" : "write");
+        }
+        return static_cast<std::size_t>(op_.result);
+    }
+
+private:
+    struct CancelOnStop {
+        IoAwaiter* self;
+
+        void operator()() const noexcept { self->service_.cancel(&self->op_); }
+    };
+
+    IoService& service_;
+    IoOperation op_;
+    std::optional<std::stop_callback<CancelOnStop>> on_stop_;
+};
+
+}  // namespace detail
+
+// ============================================================================
+// File - An open file descriptor with awaitable positional I/O
+// ============================================================================
+
+class File {
+public:
+    // Throws std::system_error if the file cannot be opened
+    static File open(const std::filesystem::path& path, int flags, mode_t mode = 0644,
+                     IoService& io = IoService::instance()) {
+        int fd = ::open(path.c_str(), flags | O_CLOEXEC, mode);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path.string());
+        return File(fd, io);
+    }
+
+    // Takes ownership of `fd`
+    File(int fd, IoService& io) noexcept : fd_(fd), io_(&io) {}
+
+    ~File() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    File(File&& other) noexcept : fd_(std::exchange(other.fd_, -1)), io_(other.io_) {}
+
+    File& operator=(File&& other) noexcept {
+        if (this != &other) {
+            if (fd_ >= 0) ::close(fd_);
+            fd_ = std::exchange(other.fd_, -1);
+            io_ = other.io_;
+        }
+        return *this;
+    }
+
+    // co_await yields the number of bytes read (0 at end of file)
+    detail::IoAwaiter read(std::uint64_t offset, std::span<std::byte> buffer) {
+        return {*io_, detail::IoOperation::Kind::read, fd_, offset, buffer.data(), buffer.size()};
+    }
+
+    // co_await yields the number of bytes written
+    detail::IoAwaiter write(std::uint64_t offset, std::span<const std::byte> data) {
+        return {*io_, detail::IoOperation::Kind::write, fd_, offset, const_cast<std::byte*>(data.data()),
+                data.size()};
+    }
+
+    int native_handle() const noexcept { return fd_; }
+
+private:
+    int fd_;
+    IoService* io_;
+};
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// ============================================================================
+// Coroutine frame allocation
+// ============================================================================
+//
+// Promise types that derive from PooledFramePromise get their frames from a
+// per-thread pool of size-class free lists instead of global operator new.
+// A coroutine can also put its frame into a caller-provided FrameArena by
+// taking `std::allocator_arg_t, FrameArena&` as its leading parameters:
+//
+//     Generator<int> numbers(std::allocator_arg_t, FrameArena&, int count);
+//     auto gen = numbers(std::allocator_arg, arena, 10);
+//
+// A coroutine without those parameters can be placed in an arena by the
+// caller with in_frame():
+//
+//     InlineFrame<128> frame;                      // On the stack
+//     auto gen = in_frame(frame, [] { return range(0, 10); });
+//
+// Every frame carries a trailing pointer naming the arena it came from
+// (null for the pool), so operator delete can route it back.
+
+// Bump allocator over caller-owned memory. Frames are released in bulk: the
+// arena rewinds once every frame allocated from it has been destroyed. The
+// buffer may have any alignment; each frame starts at the next address
+// aligned for operator new, so a misaligned buffer loses a few bytes.
+class FrameArena {
+public:
+    explicit FrameArena(std::span<std::byte> buffer) : buffer_(buffer) {}
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(std::size_t size) {
+        constexpr std::uintptr_t align = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+        // Align the address, not the offset
+        auto base = reinterpret_cast<std::uintptr_t>(buffer_.data());
+        std::size_t start = ((base + used_ + align - 1) & ~(align - 1)) - base;
+        if (start + size > buffer_.size()) {
+            throw std::bad_alloc();
+        }
+        used_ = start + size;
+        ++live_;
+        return buffer_.data() + start;
+    }
+
+    void deallocate(void*, std::size_t) noexcept {
+        if (--live_ == 0) used_ = 0;
+    }
+
+    std::size_t used() const { return used_; }
+    std::size_t capacity() const { return buffer_.size(); }
+    std::size_t live_frames() const { return live_; }
+
+private:
+    std::span<std::byte> buffer_;
+    std::size_t used_ = 0;
+    std::size_t live_ = 0;
+};
+
+namespace detail {
+
+template<std::size_t N>
+struct InlineStorage {
+    alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) std::byte bytes[N];
+};
+
+// Set by in_frame() for the next pooled frame created on this thread
+inline FrameArena*& next_frame_arena() noexcept {
+    thread_local FrameArena* arena = nullptr;
+    return arena;
+}
+
+}  // namespace detail
+
+// An arena over a buffer of N bytes inside the object itself, for a frame
+// that never outlives its caller: declared next to the generator on the
+// stack, or as a member next to the task it holds. Nothing is allocated.
+//
+// How large a frame is only the compiler knows, and only after
+// optimization, so a frame that does not fit cannot be rejected at compile
+// time. It fails at creation instead: the coroutine call throws
+// std::bad_alloc. While a frame is alive, used() gives the size it
+// actually needs, trailer included. Destroying an InlineFrame while a
+// frame in it is still alive terminates.
+template<std::size_t N>
+class InlineFrame : private detail::InlineStorage<N>, public FrameArena {
+    static_assert(N > sizeof(FrameArena*), "an inline frame needs room for the frame and its trailer");
+
+public:
+    InlineFrame() : FrameArena(this->bytes) {}
+
+    ~InlineFrame() {
+        if (live_frames() != 0) std::terminate();  // The frame escaped its storage
+    }
+};
+
+namespace detail {
+
+// Per-thread cache of frame-sized blocks, one free list per 64-byte size
+// class. Blocks come from global operator new, so a frame created on one
+// thread may be destroyed on another; it then simply joins the destroying
+// thread's cache.
+class FramePool {
+public:
+    static constexpr std::size_t granularity = 64;
+    static constexpr std::size_t class_count = 16;     // Frames up to 1 KiB
+    static constexpr std::size_t max_cached = 1024;    // Per size class
+
+    FramePool() { state() = State::alive; }
+
+    ~FramePool() {
+        state() = State::destroyed;
+        for (auto& list : free_) {
+            while (list.head) {
+                Block* next = list.head->next;
+                ::operator delete(list.head);
+                list.head = next;
+            }
+        }
+    }
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    void* allocate(std::size_t size) {
+        std::size_t index = class_of(size);
+        if (index < class_count) {
+            FreeList& list = free_[index];
+            if (list.head) {
+                Block* block = list.head;
+                list.head = block->next;
+                --list.count;
+                return block;
+            }
+        }
+        return ::operator new(block_size(size));
+    }
+
+    // What a block for `size` bytes really holds. Every block in the pooled
+    // range has its size class's full size, wherever it was allocated, since
+    // any thread's pool may end up caching it.
+    static std::size_t block_size(std::size_t size) {
+        std::size_t index = class_of(size);
+        return index < class_count ? (index + 1) * granularity : size;
+    }
+
+    void deallocate(void* p, std::size_t size) noexcept {
+        std::size_t index = class_of(size);
+        if (index < class_count && free_[index].count < max_cached) {
+            FreeList& list = free_[index];
+            list.head = ::new (p) Block{list.head};
+            ++list.count;
+            return;
+        }
+        ::operator delete(p);
+    }
+
+    // Frames can outlive the pool: after it is torn down at thread exit,
+    // the thread falls back to global new/delete
+    static bool usable() { return state() != State::destroyed; }
+
+    static FramePool& local() {
+        thread_local FramePool pool;
+        return pool;
+    }
+
+private:
+    enum class State : unsigned char { unborn, alive, destroyed };
+
+    static State& state() {
+        thread_local State current = State::unborn;  // Trivial: never torn down
+        return current;
+    }
+
+    struct Block {
+        Block* next;
+    };
+
+    struct FreeList {
+        Block* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    static std::size_t class_of(std::size_t size) { return (size + granularity - 1) / granularity - 1; }
+
+    FreeList free_[class_count];
+};
+
+inline void* allocate_frame(std::size_t size, FrameArena* arena) {
+    const std::size_t total = size + sizeof(FrameArena*);
+    void* frame = arena                 ? arena->allocate(total)
+                  : FramePool::usable() ? FramePool::local().allocate(total)
+                                        : ::operator new(FramePool::block_size(total));
+    std::memcpy(static_cast<std::byte*>(frame) + size, &arena, sizeof(arena));
+    return frame;
+}
+
+inline void deallocate_frame(void* frame, std::size_t size) noexcept {
+    FrameArena* arena;
+    std::memcpy(&arena, static_cast<std::byte*>(frame) + size, sizeof(arena));
+    const std::size_t total = size + sizeof(FrameArena*);
+
+    if (arena) {
+        arena->deallocate(frame, total);
+    } else if (FramePool::usable()) {
+        FramePool::local().deallocate(frame, total);
+    } else {
+        ::operator delete(frame);  // Thread is exiting; its pool is gone
+    }
+}
+
+}  // namespace detail
+
+// Base class for promise types whose frames should bypass global new/delete
+struct PooledFramePromise {
+    static void* operator new(std::size_t size) {
+        FrameArena*& next = detail::next_frame_arena();
+        return detail::allocate_frame(size, std::exchange(next, nullptr));
+    }
+
+    // Free coroutine: (std::allocator_arg, arena, args...)
+    template<typename... Args>
+    static void* operator new(std::size_t size, std::allocator_arg_t, FrameArena& arena, Args&&...) {
+        return detail::allocate_frame(size, &arena);
+    }
+
+    // Member coroutine: the implicit object parameter comes first
+    template<typename Self, typename... Args>
+    static void* operator new(std::size_t size, Self&, std::allocator_arg_t, FrameArena& arena,
+                              Args&&...) {
+        return detail::allocate_frame(size, &arena);
+    }
+
+    static void operator delete(void* frame, std::size_t size) noexcept {
+        detail::deallocate_frame(frame, size);
+    }
+
+    // Match the placement forms of operator new above; also used if
+    // setting up the frame throws
+    template<typename... Args>
+    static void operator delete(void* frame, std::size_t size, std::allocator_arg_t, FrameArena&,
+                                Args&&...) noexcept {
+        detail::deallocate_frame(frame, size);
+    }
+
+    template<typename Self, typename... Args>
+    static void operator delete(void* frame, std::size_t size, Self&, std::allocator_arg_t, FrameArena&,
+                                Args&&...) noexcept {
+        detail::deallocate_frame(frame, size);
+    }
+};
+
+// Calls make() and places the first pooled coroutine frame it creates in
+// `arena`. Meant for a single coroutine call: in `in_frame(frame, [&] {
+// return outer(inner()); })` the frame of inner() is the one placed, since
+// arguments are evaluated first. Throws std::logic_error if make() created
+// no frame that could take the arena, so a frame never silently falls back
+// to the pool.
+template<typename F>
+std::invoke_result_t<F&> in_frame(FrameArena& arena, F make) {
+    struct Claim {
+        explicit Claim(FrameArena& a) { detail::next_frame_arena() = &a; }
+        ~Claim() { detail::next_frame_arena() = nullptr; }
+        bool taken() const { return detail::next_frame_arena() == nullptr; }
+    } claim(arena);
+
+    auto result = make();
+    if (!claim.taken()) {
+        throw std::logic_error("in_frame: no coroutine frame was created");
+    }
+    return result;
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+#include "frame_allocator.h"
+#include "trace.h"
+
+// ============================================================================
+// Generator - Lazily produces a sequence of values with co_yield
+// ============================================================================
+//
+// The promise never copies a yielded value. It keeps a pointer to the object
+// named in co_yield, which stays alive in the suspended frame until the
+// generator is resumed:
+//
+//   Generator<T>         value() gives a const T&; take() moves the value out
+//                        when it was yielded as an rvalue (and copies it
+//                        otherwise)
+//   Generator<T&>        value() gives a T& to the producer's object
+//   Generator<const T&>  value() gives a const T& to the producer's object
+//
+// Either way the reference is only valid until the next call to next().
+//
+// A Generator is also a single-pass range: begin() starts the coroutine and
+// each ++ resumes it, so it works in range-for and as a std::ranges view:
+//
+//   for (int v : range(0, 10) | std::views::filter(is_odd)) ...
+//
+// `co_yield elements_of(child)` delegates to a nested Generator of the same
+// type. The root keeps track of the innermost active generator and the
+// consumer resumes that one directly, so each element costs O(1) no matter
+// how deep the nesting. Any other range is wrapped in one extra level.
+
+template<typename R>
+struct elements_of {
+    explicit elements_of(R&& r) : range(std::forward<R>(r)) {}
+
+    R range;
+};
+
+template<typename R>
+elements_of(R&&) -> elements_of<R>;
+
+template<typename T>
+struct Generator : std::ranges::view_base {
+    using value_type = std::remove_cvref_t<T>;
+    using reference = std::conditional_t<std::is_reference_v<T>, T, const value_type&>;
+    using pointer = std::add_pointer_t<reference>;
+
+    struct promise_type : PooledFramePromise {
+        // Only meaningful on the root promise: nested generators write the
+        // yielded value into their root
+        pointer current = nullptr;
+        bool movable = false;  // current names an rvalue the consumer may steal
+        std::exception_ptr exception;
+
+        promise_type* root = this;
+        std::coroutine_handle<promise_type> parent;  // Null for the root
+        std::coroutine_handle<promise_type> leaf;    // Root only: innermost active generator
+
+        ~promise_type() { COROUTINE_TRACE_DESTROY(trace::frame_id(*this)); }
+
+        Generator get_return_object() {
+            auto h = std::coroutine_handle<promise_type>::from_promise(*this);
+            COROUTINE_TRACE_CREATE("Generator", h.address());
+            leaf = h;
+            return Generator{h};
+        }
+
+        // A finished nested generator hands control back to its parent
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                COROUTINE_TRACE_SUSPEND("final", h.address());
+                auto& promise = h.promise();
+                if (promise.parent) {
+                    promise.root->leaf = promise.parent;
+                    return promise.parent;
+                }
+                return std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        // Starts the child in place of the parent; the parent resumes once
+        // the child is exhausted
+        struct NestedAwaiter {
+            Generator child;
+
+            bool await_ready() const noexcept { return !child.handle; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                COROUTINE_TRACE_SUSPEND("elements_of", h.address());
+                COROUTINE_TRACE_RESUME(child.handle.address());
+                auto& nested = child.handle.promise();
+                nested.root = h.promise().root;
+                nested.parent = h;
+                nested.root->leaf = child.handle;
+                return child.handle;
+            }
+
+            void await_resume() {
+                if (!child.handle) return;
+                COROUTINE_TRACE_RESUME(child.handle.promise().parent.address());
+                if (child.handle.promise().exception) {
+                    std::rethrow_exception(child.handle.promise().exception);
+                }
+            }
+        };
+
+        std::suspend_always initial_suspend() { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        std::suspend_always yield_value(reference value) noexcept {
+            COROUTINE_TRACE_SUSPEND("yield", trace::frame_id(*this));
+            root->current = std::addressof(value);
+            root->movable = false;
+            return {};
+        }
+
+        // A temporary lives until the end of the co_yield expression, which
+        // spans the whole suspension
+        std::suspend_always yield_value(value_type&& value) noexcept
+            requires(!std::is_reference_v<T>)
+        {
+            COROUTINE_TRACE_SUSPEND("yield", trace::frame_id(*this));
+            root->current = std::addressof(value);
+            root->movable = true;
+            return {};
+        }
+
+        NestedAwaiter yield_value(elements_of<Generator> nested) noexcept {
+            return NestedAwaiter{std::move(nested.range)};
+        }
+
+        template<std::ranges::input_range R>
+        NestedAwaiter yield_value(elements_of<R> nested) {
+            return NestedAwaiter{flatten<R>(std::forward<R>(nested.range))};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+    private:
+        template<typename R>
+        static Generator flatten(R range) {
+            for (auto&& element : range) {
+                co_yield element;
+            }
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    Generator() = default;
+    Generator(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+    ~Generator() {
+        if (handle) handle.destroy();
+    }
+
+    // Move-only type
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    Generator(Generator&& other) noexcept : handle(other.handle) {
+        other.handle = nullptr;
+    }
+
+    Generator& operator=(Generator&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = other.handle;
+            other.handle = nullptr;
+        }
+        return *this;
+    }
+
+    bool next() {
+        resume(handle);
+        return !handle.done();
+    }
+
+    reference value() const {
+        return static_cast<reference>(*handle.promise().current);
+    }
+
+    // Moves the current value out when it was yielded as an rvalue
+    value_type take() const
+        requires(!std::is_reference_v<T>)
+    {
+        auto& promise = handle.promise();
+        if (promise.movable) {
+            return std::move(*const_cast<value_type*>(promise.current));
+        }
+        return *promise.current;
+    }
+
+    class Iterator {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = Generator::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        explicit Iterator(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+        reference operator*() const {
+            return static_cast<reference>(*handle_.promise().current);
+        }
+
+        Iterator& operator++() {
+            resume(handle_);
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const Iterator& it, std::default_sentinel_t) noexcept {
+            return !it.handle_ || it.handle_.done();
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    // Runs the coroutine up to its first co_yield. Call it once: there is
+    // only one pass over the sequence.
+    Iterator begin() {
+        if (handle) resume(handle);
+        return Iterator{handle};
+    }
+
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    // Resumes the innermost active generator; `root` reports completion
+    // and any exception that escaped the whole nest
+    static void resume(std::coroutine_handle<promise_type> root) {
+        COROUTINE_TRACE_RESUME(root.promise().leaf.address());
+        root.promise().leaf.resume();
+        if (root.promise().exception) {
+            std::rethrow_exception(root.promise().exception);
+        }
+    }
+};
+
+static_assert(std::ranges::input_range<Generator<int>>);
+static_assert(std::ranges::view<Generator<int>>);
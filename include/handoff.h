@@ -0,0 +1,63 @@
+#pragma once
+
+#include <coroutine>
+
+// ============================================================================
+// Hand-off - Resume coroutines that were given a lock, permit or slot
+// ============================================================================
+//
+// When a coroutine releases something a parked coroutine is waiting for, it
+// hands it over directly and resumes the waiter on its own thread. A waiter
+// that releases in turn would nest another resume() inside the first one,
+// so a long line of waiters could overflow the stack. Instead, only the
+// outermost hand-off on a thread resumes anything; nested hand-offs append
+// to its queue and return at once. Stack use stays constant, and waiters
+// still run in the order they were handed off.
+
+namespace detail {
+
+// Intrusive node for parked awaiters; the awaiter lives in the suspended
+// frame, so queueing it allocates nothing
+struct Waiter {
+    std::coroutine_handle<> handle;
+    Waiter* next = nullptr;
+};
+
+class HandoffQueue {
+public:
+    // `first` .. `last` are linked through `next`, in resume order
+    static void resume(Waiter* first, Waiter* last) noexcept {
+        if (!first) return;
+        HandoffQueue& queue = local();
+        last->next = nullptr;
+        if (queue.tail_) {
+            queue.tail_->next = first;
+        } else {
+            queue.head_ = first;
+        }
+        queue.tail_ = last;
+        if (queue.running_) return;
+
+        queue.running_ = true;
+        while (Waiter* waiter = queue.head_) {
+            queue.head_ = waiter->next;
+            if (!queue.head_) queue.tail_ = nullptr;
+            waiter->handle.resume();  // The node is gone once this returns
+        }
+        queue.running_ = false;
+    }
+
+    static void resume(Waiter* waiter) noexcept { resume(waiter, waiter); }
+
+private:
+    static HandoffQueue& local() noexcept {
+        thread_local HandoffQueue queue;
+        return queue;
+    }
+
+    Waiter* head_ = nullptr;
+    Waiter* tail_ = nullptr;
+    bool running_ = false;
+};
+
+}  // namespace detail
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "frame_allocator.h"
+#include "trace.h"
+
+// ============================================================================
+// Interleaved lookups - Overlap the cache misses of many independent probes
+// ============================================================================
+//
+//   Interleaved<const Entry*> find(const Table& table, std::uint64_t key) {
+//       std::size_t i = table.slot_of(key);
+//       for (;; i = (i + 1) & table.mask) {
+//           co_await prefetch(&table.slots[i]);     // Start the load, let another lookup run
+//           if (table.slots[i].key == key) co_return &table.slots[i];
+//           if (table.slots[i].key == 0) co_return nullptr;
+//       }
+//   }
+//
+//   InterleavedExecutor executor(16);               // Up to 16 lookups in flight
+//   executor.run(keys, [&](std::uint64_t key) { return find(table, key); },
+//                [&](std::size_t index, const Entry* entry) { results[index] = entry; });
+//
+// A probe into a table much larger than the cache spends most of its time
+// waiting for one load, and a loop of probes waits for them one after the
+// other. Written as a coroutine, a probe issues a prefetch for the address
+// it is about to read and suspends. The executor resumes the next lookup in
+// its group, which issues its own prefetch, and so on round-robin, so up to
+// group_size misses are outstanding at once. By the time a lookup is
+// resumed again its line has usually arrived.
+//
+// The best group size depends on the machine (how many misses a core can
+// keep in flight) and on how much work a lookup does between loads: too
+// small leaves misses exposed, too large evicts lines before they are used.
+// Eight to sixteen is a typical start; measure with interleave_bench.
+//
+// Lookups run on the calling thread, inside run(). A lookup may only
+// co_await prefetch(): nothing else may resume it. Each result is handed to
+// the sink with the position of its input, as lookups finish out of order.
+// An exception from a lookup or the sink is rethrown from run() after the
+// lookups still in flight have been destroyed.
+
+namespace detail {
+
+struct PrefetchAwaiter {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend([[maybe_unused]] std::coroutine_handle<> h) const noexcept {
+        COROUTINE_TRACE_SUSPEND("prefetch", h.address());
+    }
+    void await_resume() const noexcept {}
+};
+
+}  // namespace detail
+
+// co_await prefetch(p): starts loading the cache line at p and suspends
+// until the executor comes back to this lookup
+inline detail::PrefetchAwaiter prefetch(const void* address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+    return {};
+}
+
+// One lookup run by InterleavedExecutor; lazy until the executor starts it
+template<typename T>
+class Interleaved {
+    static_assert(!std::is_void_v<T>, "a lookup produces a value for the sink");
+
+public:
+    struct promise_type : PooledFramePromise {
+        std::optional<T> value;
+        std::exception_ptr exception;
+
+        ~promise_type() { COROUTINE_TRACE_DESTROY(trace::frame_id(*this)); }
+
+        Interleaved get_return_object() {
+            auto h = std::coroutine_handle<promise_type>::from_promise(*this);
+            COROUTINE_TRACE_CREATE("Interleaved", h.address());
+            return Interleaved{h};
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        // Only the executor resumes a lookup, so prefetch() is the only
+        // thing it may wait for
+        detail::PrefetchAwaiter await_transform(detail::PrefetchAwaiter awaiter) noexcept { return awaiter; }
+
+        template<typename U>
+        void return_value(U&& v) {
+            value.emplace(std::forward<U>(v));
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+    };
+
+    explicit Interleaved(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+    ~Interleaved() {
+        if (handle_) handle_.destroy();
+    }
+
+    // Move-only type
+    Interleaved(const Interleaved&) = delete;
+    Interleaved& operator=(const Interleaved&) = delete;
+
+    Interleaved(Interleaved&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Interleaved& operator=(Interleaved&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    // Hands the frame over; the caller destroys it
+    std::coroutine_handle<promise_type> release() noexcept { return std::exchange(handle_, nullptr); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Runs a batch of lookups round-robin, group_size of them at a time
+class InterleavedExecutor {
+public:
+    explicit InterleavedExecutor(std::size_t group_size = 8) : group_size_(group_size > 0 ? group_size : 1) {}
+
+    std::size_t group_size() const noexcept { return group_size_; }
+    void set_group_size(std::size_t group_size) noexcept { group_size_ = group_size > 0 ? group_size : 1; }
+
+    // Calls make(input) for every element of `inputs`, which must return an
+    // Interleaved<T>, and sink(index, T&&) with each result. Returns once
+    // every lookup has finished.
+    template<std::ranges::input_range Inputs, typename Make, typename Sink>
+    void run(Inputs&& inputs, Make make, Sink sink) {
+        using Lookup = std::invoke_result_t<Make&, std::ranges::range_reference_t<Inputs>>;
+        using Handle = std::coroutine_handle<typename Lookup::promise_type>;
+
+        struct Slot {
+            Handle handle;
+            std::size_t index;
+        };
+
+        // Frames still in flight when an exception leaves run()
+        struct Slots : std::vector<Slot> {
+            ~Slots() {
+                for (Slot& slot : *this) {
+                    if (slot.handle) slot.handle.destroy();
+                }
+            }
+        } slots;
+        slots.reserve(group_size_);
+
+        auto it = std::ranges::begin(inputs);
+        auto end = std::ranges::end(inputs);
+        std::size_t next_index = 0;
+
+        auto finish = [&](Slot& slot) {
+            auto& promise = slot.handle.promise();
+            if (promise.exception) std::rethrow_exception(promise.exception);
+            std::invoke(sink, slot.index, std::move(*promise.value));
+            slot.handle.destroy();
+            slot.handle = nullptr;
+        };
+
+        // Starts lookups in `slot` until one suspends; false once the inputs
+        // are used up. A lookup that never suspends is finished right here.
+        auto start = [&](Slot& slot) {
+            while (it != end) {
+                slot = Slot{std::invoke(make, *it).release(), next_index++};
+                ++it;
+                COROUTINE_TRACE_RESUME(slot.handle.address());
+                slot.handle.resume();
+                if (!slot.handle.done()) return true;
+                finish(slot);
+            }
+            return false;
+        };
+
+        while (slots.size() < group_size_) {
+            slots.push_back(Slot{});
+            if (!start(slots.back())) {
+                slots.pop_back();
+                break;
+            }
+        }
+
+        while (!slots.empty()) {
+            for (std::size_t i = 0; i < slots.size();) {
+                Slot& slot = slots[i];
+                COROUTINE_TRACE_RESUME(slot.handle.address());
+                slot.handle.resume();
+                if (slot.handle.done()) {
+                    finish(slot);
+                    if (!start(slot)) {
+                        // Out of inputs: the group shrinks
+                        slot = slots.back();
+                        slots.back().handle = nullptr;
+                        slots.pop_back();
+                        continue;
+                    }
+                }
+                ++i;
+            }
+        }
+    }
+
+private:
+    std::size_t group_size_;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <stop_token>
+#include <utility>
+
+#include "task.h"
+
+// ============================================================================
+// LazyTask - Computation that does not run until it is awaited or started
+// ============================================================================
+//
+// Unlike Task, creating a LazyTask only allocates its frame. The body runs
+// when the task is first co_await'ed (the awaiter transfers straight into
+// it), when start() is called, or on an executor via schedule_on(). Tasks
+// can therefore be built in batches and handed to whoever should run them.
+
+template<typename T>
+struct LazyTask {
+    struct promise_type : detail::TaskPromiseBase<T> {
+        using State = typename detail::TaskPromiseBase<T>::State;
+
+        promise_type() : detail::TaskPromiseBase<T>(State::not_started) {
+            COROUTINE_TRACE_CREATE("LazyTask", trace::frame_id(*this));
+        }
+
+        template<typename... Args>
+        explicit promise_type(std::stop_token token, Args&&...) : promise_type() {
+            this->stop_token = std::move(token);
+        }
+
+        ~promise_type() { COROUTINE_TRACE_DESTROY(trace::frame_id(*this)); }
+
+        LazyTask get_return_object() {
+            return LazyTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        // Wait to be started
+        struct InitialAwaiter : std::suspend_always {
+            promise_type* promise;
+
+            void await_resume() const noexcept { COROUTINE_TRACE_RESUME(trace::frame_id(*promise)); }
+        };
+
+        InitialAwaiter initial_suspend() { return {{}, this}; }
+
+        void return_value(T v) {
+            this->value = std::move(v);
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    LazyTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+    ~LazyTask() {
+        if (handle) handle.destroy();
+    }
+
+    LazyTask(const LazyTask&) = delete;
+    LazyTask& operator=(const LazyTask&) = delete;
+
+    LazyTask(LazyTask&& other) noexcept : handle(other.handle) {
+        other.handle = nullptr;
+    }
+
+    LazyTask& operator=(LazyTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = other.handle;
+            other.handle = nullptr;
+        }
+        return *this;
+    }
+
+    // Awaiting a task that has not started yet runs it right away on the
+    // awaiting thread; awaiting a started one waits for it to finish
+    auto operator co_await() & noexcept { return detail::TaskAwaiter<promise_type>{handle}; }
+    auto operator co_await() && noexcept { return detail::MovingTaskAwaiter<promise_type>{{handle}}; }
+
+    // Runs the task on the calling thread until its first suspension
+    void start() {
+        if (mark_started()) handle.resume();
+    }
+
+    // Queues the task on an executor, such as Scheduler, that has a
+    // post(std::coroutine_handle<>) member
+    template<typename Executor>
+    void schedule_on(Executor& executor) {
+        if (mark_started()) executor.post(handle);
+    }
+
+    // Starts the task if needed and blocks until it finishes
+    T get() {
+        return sync_wait(*this);
+    }
+
+    bool is_started() const {
+        return handle.promise().state.load(std::memory_order_acquire) !=
+               promise_type::State::not_started;
+    }
+
+    bool is_ready() const {
+        return handle.promise().state.load(std::memory_order_acquire) ==
+               promise_type::State::finished;
+    }
+
+private:
+    bool mark_started() {
+        auto expected = promise_type::State::not_started;
+        return handle.promise().state.compare_exchange_strong(expected, promise_type::State::running,
+                                                               std::memory_order_acq_rel);
+    }
+};
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "generator.h"
+
+// ============================================================================
+// Pipelines - map / filter / take fused into a single loop
+// ============================================================================
+//
+//   long total = range(0, n)
+//              | fuse::map([](int v) { return v * 3; })
+//              | fuse::filter([](int v) { return v % 2 == 0; })
+//              | fuse::take(1000)
+//              | fuse::reduce(0L, std::plus<>());
+//
+// Writing each stage as its own Generator costs one coroutine frame per
+// stage, and one resume per stage for every element. Here the stages are
+// plain objects composed at compile time. The terminal operation (reduce,
+// for_each, to_vector) runs one loop over the source and pushes each
+// element through every stage by direct, inlinable calls. The source's own
+// resume is the only suspension left. take() stops the loop early, so the
+// source is not resumed past the last element needed; after take(0) it is
+// not resumed at all.
+//
+// to_generator() packages a fused pipeline as a single Generator when a
+// lazy sequence is needed: one frame for all the stages, not one each.
+//
+// Stages can be composed ahead of time and reused:
+//
+//   auto evens_tripled = fuse::filter(is_even) | fuse::map(triple);
+//   auto a = numbers() | evens_tripled | fuse::to_vector();
+//
+// Any input range can be the source. A Generator is moved in; a container
+// passed as an lvalue is referenced, not copied.
+
+namespace fuse {
+
+// ----------------------------------------------------------------------------
+// Stages: take a value and the rest of the chain, return false to stop.
+// A stage that can be finished before any value arrives also has done().
+// ----------------------------------------------------------------------------
+
+template<typename F>
+struct Map {
+    F fn;
+
+    template<typename In>
+    using output = std::invoke_result_t<F&, In>;
+
+    template<typename V, typename Next>
+    bool operator()(V&& value, Next& next) {
+        return next(std::invoke(fn, std::forward<V>(value)));
+    }
+};
+
+template<typename P>
+struct Filter {
+    P predicate;
+
+    template<typename In>
+    using output = In;
+
+    template<typename V, typename Next>
+    bool operator()(V&& value, Next& next) {
+        if (!std::invoke(predicate, std::as_const(value))) return true;
+        return next(std::forward<V>(value));
+    }
+};
+
+struct Take {
+    std::size_t remaining;
+
+    template<typename In>
+    using output = In;
+
+    template<typename V, typename Next>
+    bool operator()(V&& value, Next& next) {
+        if (remaining == 0) return false;
+        bool more = next(std::forward<V>(value));
+        return --remaining > 0 && more;
+    }
+
+    bool done() const { return remaining == 0; }
+};
+
+template<typename S>
+bool stage_done(const S& stage) {
+    if constexpr (requires { stage.done(); }) {
+        return stage.done();
+    } else {
+        return false;
+    }
+}
+
+// What a value of type In becomes after passing through Stages
+template<typename In, typename... Stages>
+struct chain_output {
+    using type = In;
+};
+
+template<typename In, typename First, typename... Rest>
+struct chain_output<In, First, Rest...> : chain_output<typename First::template output<In>, Rest...> {};
+
+// Stages in the order they apply
+template<typename... Stages>
+struct Chain {
+    std::tuple<Stages...> stages;
+
+    template<typename In>
+    using output = typename chain_output<In, Stages...>::type;
+
+    // True if some stage would stop at the first value, so the source need
+    // not be resumed at all
+    bool done() const {
+        return std::apply([](const auto&... stage) { return (stage_done(stage) || ...); }, stages);
+    }
+
+    // Runs `value` through the stages from I on, then hands it to `sink`.
+    // False means the pipeline is finished.
+    template<std::size_t I = 0, typename V, typename Sink>
+    bool push(V&& value, Sink& sink) {
+        if constexpr (I == sizeof...(Stages)) {
+            return sink(std::forward<V>(value));
+        } else {
+            auto next = [&](auto&& out) { return push<I + 1>(std::forward<decltype(out)>(out), sink); };
+            return std::get<I>(stages)(std::forward<V>(value), next);
+        }
+    }
+};
+
+template<typename T>
+inline constexpr bool is_stage = false;
+template<typename F>
+inline constexpr bool is_stage<Map<F>> = true;
+template<typename P>
+inline constexpr bool is_stage<Filter<P>> = true;
+template<>
+inline constexpr bool is_stage<Take> = true;
+
+template<typename T>
+inline constexpr bool is_chain = false;
+template<typename... Stages>
+inline constexpr bool is_chain<Chain<Stages...>> = true;
+
+template<typename T>
+concept Composable = is_stage<T> || is_chain<T>;
+
+template<typename S>
+auto as_chain(S stage) {
+    if constexpr (is_chain<S>) {
+        return stage;
+    } else {
+        return Chain<S>{std::tuple<S>(std::move(stage))};
+    }
+}
+
+// stage | stage, chain | stage, ...: one Chain with all of them
+template<Composable A, Composable B>
+auto operator|(A a, B b) {
+    auto left = as_chain(std::move(a));
+    auto right = as_chain(std::move(b));
+    return std::apply(
+        [](auto&&... stages) { return Chain<std::remove_cvref_t<decltype(stages)>...>{{std::move(stages)...}}; },
+        std::tuple_cat(std::move(left.stages), std::move(right.stages)));
+}
+
+template<typename F>
+Map<std::decay_t<F>> map(F&& fn) {
+    return {std::forward<F>(fn)};
+}
+
+template<typename P>
+Filter<std::decay_t<P>> filter(P&& predicate) {
+    return {std::forward<P>(predicate)};
+}
+
+inline Take take(std::size_t count) {
+    return {count};
+}
+
+// ----------------------------------------------------------------------------
+// A source with the stages applied to it, waiting for a terminal operation
+// ----------------------------------------------------------------------------
+
+template<std::ranges::input_range Source, typename Stages>
+struct Fused {
+    Source source;
+    Stages chain;
+
+    using input = std::ranges::range_reference_t<Source>;
+    using reference = typename Stages::template output<input>;
+    using value_type = std::remove_cvref_t<reference>;
+
+    // Drives the single loop; `sink` returns false to stop early
+    template<typename Sink>
+    void run(Sink&& sink) {
+        if (chain.done()) return;
+        for (auto&& value : source) {
+            if (!chain.push(std::forward<decltype(value)>(value), sink)) break;
+        }
+    }
+};
+
+template<std::ranges::viewable_range R, Composable S>
+auto operator|(R&& source, S stages) {
+    using Source = std::views::all_t<R>;
+    auto chain = as_chain(std::move(stages));
+    return Fused<Source, decltype(chain)>{std::views::all(std::forward<R>(source)), std::move(chain)};
+}
+
+template<typename Source, typename Stages, Composable S>
+auto operator|(Fused<Source, Stages> fused, S stages) {
+    auto chain = std::move(fused.chain) | std::move(stages);
+    return Fused<Source, decltype(chain)>{std::move(fused.source), std::move(chain)};
+}
+
+// ----------------------------------------------------------------------------
+// Terminal operations
+// ----------------------------------------------------------------------------
+
+template<typename F>
+struct ForEach {
+    F fn;
+
+    template<typename Fused>
+    void operator()(Fused& fused) {
+        fused.run([&](auto&& value) {
+            std::invoke(fn, std::forward<decltype(value)>(value));
+            return true;
+        });
+    }
+};
+
+template<typename T, typename Op>
+struct Reduce {
+    T init;
+    Op op;
+
+    template<typename Fused>
+    T operator()(Fused& fused) {
+        T accumulator = std::move(init);
+        fused.run([&](auto&& value) {
+            accumulator = std::invoke(op, std::move(accumulator), std::forward<decltype(value)>(value));
+            return true;
+        });
+        return accumulator;
+    }
+};
+
+struct ToVector {
+    template<typename Fused>
+    auto operator()(Fused& fused) {
+        std::vector<typename Fused::value_type> out;
+        fused.run([&](auto&& value) {
+            out.push_back(std::forward<decltype(value)>(value));
+            return true;
+        });
+        return out;
+    }
+};
+
+// The stages run inside this one coroutine; each output is yielded from a
+// slot in its frame
+template<typename Fused>
+Generator<typename Fused::value_type> fused_generator(Fused fused) {
+    std::optional<typename Fused::value_type> slot;
+    if (fused.chain.done()) co_return;
+    for (auto&& value : fused.source) {
+        auto store = [&](auto&& out) {
+            slot.emplace(std::forward<decltype(out)>(out));
+            return true;
+        };
+        bool more = fused.chain.push(std::forward<decltype(value)>(value), store);
+        if (slot) {
+            co_yield std::move(*slot);
+            slot.reset();
+        }
+        if (!more) break;
+    }
+}
+
+struct ToGenerator {
+    template<typename Fused>
+    auto operator()(Fused& fused) {
+        return fused_generator(std::move(fused));
+    }
+};
+
+template<typename T>
+inline constexpr bool is_terminal = false;
+template<typename F>
+inline constexpr bool is_terminal<ForEach<F>> = true;
+template<typename T, typename Op>
+inline constexpr bool is_terminal<Reduce<T, Op>> = true;
+template<>
+inline constexpr bool is_terminal<ToVector> = true;
+template<>
+inline constexpr bool is_terminal<ToGenerator> = true;
+
+template<typename T>
+concept Terminal = is_terminal<T>;
+
+template<typename Source, typename Stages, Terminal T>
+decltype(auto) operator|(Fused<Source, Stages> fused, T terminal) {
+    return terminal(fused);
+}
+
+// A terminal straight on a source: no stages
+template<std::ranges::viewable_range R, Terminal T>
+decltype(auto) operator|(R&& source, T terminal) {
+    auto fused = Fused<std::views::all_t<R>, Chain<>>{std::views::all(std::forward<R>(source)), {}};
+    return terminal(fused);
+}
+
+template<typename F>
+ForEach<std::decay_t<F>> for_each(F&& fn) {
+    return {std::forward<F>(fn)};
+}
+
+template<typename T, typename Op = std::plus<>>
+Reduce<T, Op> reduce(T init, Op op = {}) {
+    return {std::move(init), std::move(op)};
+}
+
+inline ToVector to_vector() {
+    return {};
+}
+
+inline ToGenerator to_generator() {
+    return {};
+}
+
+}  // namespace fuse
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// WorkStealingDeque - Chase-Lev deque of coroutine handles
+// ============================================================================
+//
+// The owning worker pushes and pops at the bottom (LIFO, cache-warm); other
+// workers steal from the top (FIFO). Only the owner may call push()/pop().
+// Based on "Correct and Efficient Work-Stealing for Weak Memory Models"
+// (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(std::size_t capacity = 256)
+        : ring_(new Ring(capacity)) {
+        retired_.emplace_back(ring_.load(std::memory_order_relaxed));
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    void push(std::coroutine_handle<> handle) {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+
+        if (b - t > static_cast<std::int64_t>(ring->capacity) - 1) {
+            ring = grow(ring, t, b);
+        }
+
+        ring->put(b, handle.address());
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Returns a null handle when the deque is empty
+    std::coroutine_handle<> pop() {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+
+        void* item = nullptr;
+        if (t <= b) {
+            item = ring->get(b);
+            if (t == b) {
+                // Last element: race the thieves for it
+                if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return std::coroutine_handle<>::from_address(item);
+    }
+
+    // Safe from any thread. Returns a null handle when empty or when it lost
+    // a race with another thief or the owner.
+    std::coroutine_handle<> steal() {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom_.load(std::memory_order_acquire);
+
+        if (t < b) {
+            Ring* ring = ring_.load(std::memory_order_acquire);
+            void* item = ring->get(t);
+            if (top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed)) {
+                return std::coroutine_handle<>::from_address(item);
+            }
+        }
+        return nullptr;
+    }
+
+    bool empty() const {
+        return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Ring {
+        explicit Ring(std::size_t cap)
+            : capacity(cap), mask(cap - 1), slots(new std::atomic<void*>[cap]) {}
+
+        void put(std::int64_t i, void* value) {
+            slots[static_cast<std::size_t>(i) & mask].store(value, std::memory_order_relaxed);
+        }
+        void* get(std::int64_t i) const {
+            return slots[static_cast<std::size_t>(i) & mask].load(std::memory_order_relaxed);
+        }
+
+        std::size_t capacity;  // Always a power of two
+        std::size_t mask;
+        std::unique_ptr<std::atomic<void*>[]> slots;
+    };
+
+    Ring* grow(Ring* old, std::int64_t top, std::int64_t bottom) {
+        auto* bigger = new Ring(old->capacity * 2);
+        for (std::int64_t i = top; i < bottom; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        // Thieves may still be reading the old ring, so it stays alive until
+        // the deque itself is destroyed
+        retired_.emplace_back(bigger);
+        ring_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_{0};
+    alignas(64) std::atomic<std::int64_t> bottom_{0};
+    std::atomic<Ring*> ring_;
+    std::vector<std::unique_ptr<Ring>> retired_;  // Owner-only
+};
+
+// ============================================================================
+// Scheduler - Pool of workers with per-worker deques and work stealing
+// ============================================================================
+//
+// A coroutine moves onto a worker with `co_await scheduler.schedule()`.
+// Handles scheduled from a worker go to that worker's own deque; handles
+// scheduled from outside go to a shared injection queue. Idle workers steal
+// from a randomly chosen victim before going to sleep.
+//
+// Destroying the scheduler stops the workers after the coroutine each one is
+// currently running reaches its next suspension point. Coroutines still
+// queued at that time are never resumed.
+
+class Scheduler {
+public:
+    explicit Scheduler(unsigned thread_count = std::thread::hardware_concurrency()) {
+        if (thread_count == 0) thread_count = 1;
+
+        workers_.reserve(thread_count);
+        for (unsigned i = 0; i < thread_count; ++i) {
+            workers_.push_back(std::make_unique<Worker>(i));
+        }
+        for (auto& worker : workers_) {
+            worker->thread = std::thread([this, w = worker.get()] { run(*w); });
+        }
+    }
+
+    ~Scheduler() {
+        stopping_.store(true, std::memory_order_seq_cst);
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        epoch_.notify_all();
+        for (auto& worker : workers_) {
+            worker->thread.join();
+        }
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    struct ScheduleAwaiter {
+        Scheduler* scheduler;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const { scheduler->post(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    // co_await scheduler.schedule() resumes the caller on one of the workers
+    ScheduleAwaiter schedule() { return ScheduleAwaiter{this}; }
+
+    // Queue a suspended coroutine to be resumed on a worker
+    void post(std::coroutine_handle<> handle) {
+        if (current_scheduler == this) {
+            current_worker->deque.push(handle);
+        } else {
+            std::lock_guard lock(injection_mutex_);
+            injection_.push_back(handle);
+        }
+        wake_one();
+    }
+
+    unsigned thread_count() const { return static_cast<unsigned>(workers_.size()); }
+
+    // True when called from one of this scheduler's workers
+    bool on_worker_thread() const { return current_scheduler == this; }
+
+private:
+    struct Worker {
+        explicit Worker(unsigned i) : index(i), rng_state(0x9E3779B9u * (i + 1)) {}
+
+        unsigned index;
+        std::uint32_t rng_state;
+        WorkStealingDeque deque;
+        std::thread thread;
+    };
+
+    static inline thread_local Scheduler* current_scheduler = nullptr;
+    static inline thread_local Worker* current_worker = nullptr;
+
+    void wake_one() {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            epoch_.notify_one();
+        }
+    }
+
+    std::coroutine_handle<> pop_injected() {
+        std::lock_guard lock(injection_mutex_);
+        if (injection_.empty()) return nullptr;
+        auto handle = injection_.front();
+        injection_.pop_front();
+        return handle;
+    }
+
+    std::coroutine_handle<> steal(Worker& thief) {
+        const auto count = static_cast<std::uint32_t>(workers_.size());
+        if (count < 2) return nullptr;
+
+        // xorshift32: a cheap per-worker random starting victim
+        std::uint32_t x = thief.rng_state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        thief.rng_state = x;
+
+        for (std::uint32_t i = 0; i < count; ++i) {
+            Worker& victim = *workers_[(x + i) % count];
+            if (&victim == &thief) continue;
+            if (auto handle = victim.deque.steal()) return handle;
+        }
+        return nullptr;
+    }
+
+    std::coroutine_handle<> find_work(Worker& self) {
+        if (auto handle = self.deque.pop()) return handle;
+        if (auto handle = pop_injected()) return handle;
+        return steal(self);
+    }
+
+    void run(Worker& self) {
+        current_scheduler = this;
+        current_worker = &self;
+
+        while (!stopping_.load(std::memory_order_acquire)) {
+            if (auto handle = find_work(self)) {
+                handle.resume();
+                continue;
+            }
+
+            // Announce that we are about to sleep, then look once more: a
+            // post() that raced with us either is visible now or has bumped
+            // the epoch, in which case wait() returns immediately.
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            auto epoch = epoch_.load(std::memory_order_seq_cst);
+            if (auto handle = find_work(self)) {
+                sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                handle.resume();
+                continue;
+            }
+            if (!stopping_.load(std::memory_order_acquire)) {
+                epoch_.wait(epoch, std::memory_order_seq_cst);
+            }
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        current_scheduler = nullptr;
+        current_worker = nullptr;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex injection_mutex_;
+    std::deque<std::coroutine_handle<>> injection_;
+    std::atomic<std::uint32_t> epoch_{0};
+    std::atomic<int> sleepers_{0};
+    std::atomic<bool> stopping_{false};
+};
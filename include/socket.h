@@ -0,0 +1,650 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "cancellation.h"
+
+// ============================================================================
+// Sockets - accept/recv/send awaiters on an edge-triggered epoll reactor
+// ============================================================================
+//
+//   Socket server = Socket::listen(SocketAddress::ipv4("127.0.0.1", 8080));
+//   Socket client = co_await server.accept();
+//   std::size_t n = co_await client.recv(buffer);
+//   co_await client.send(std::span(buffer).first(n));
+//
+// Every awaiter tries its system call first, and suspends only if the call
+// returns EAGAIN. When data is already waiting, co_await completes on the
+// calling thread without suspending and without involving the reactor.
+//
+// A suspended operation is parked on its socket. Each socket is registered
+// once, edge-triggered, for both directions. When epoll reports an edge,
+// the reactor thread retries the parked operations in FIFO order. Each
+// one that completes is resumed; the first one that would still block stops
+// the scan. The retry in await_suspend and the reactor's scan run under the
+// same per-socket mutex, so an edge that arrives between the fast-path
+// attempt and parking is never lost.
+//
+// Parked coroutines resume on the reactor thread. A stop request on the
+// awaiting coroutine's token (see cancellation.h) unparks the operation,
+// which then throws std::system_error with ECANCELED. Destroy a Socket only
+// when none of its operations is pending.
+//
+// If epoll_wait fails with anything but EINTR, the reactor stops: every
+// parked operation, and every one that would park later, throws
+// std::system_error with that error.
+
+class Reactor;
+class Socket;
+
+namespace detail {
+
+// One pending accept/connect/recv/send
+struct SocketOperation {
+    // Makes the system call once. False means it would block; true means
+    // it finished, with a result or an error.
+    virtual bool try_complete() = 0;
+
+    std::coroutine_handle<> waiter;
+    SocketOperation* next = nullptr;
+    int error = 0;  // errno of a failed call, or ECANCELED
+
+protected:
+    ~SocketOperation() = default;
+};
+
+// Intrusive FIFO of parked operations
+struct OperationQueue {
+    SocketOperation* head = nullptr;
+    SocketOperation* tail = nullptr;
+
+    void push(SocketOperation* op) {
+        op->next = nullptr;
+        if (tail) {
+            tail->next = op;
+        } else {
+            head = op;
+        }
+        tail = op;
+    }
+
+    // False if `op` is not parked here (it completed or was never queued)
+    bool remove(SocketOperation* op) {
+        SocketOperation* previous = nullptr;
+        for (SocketOperation* it = head; it; previous = it, it = it->next) {
+            if (it != op) continue;
+            (previous ? previous->next : head) = op->next;
+            if (tail == op) tail = previous;
+            return true;
+        }
+        return false;
+    }
+
+    // Moves the leading operations that now complete into `ready`
+    void complete_ready(std::vector<std::coroutine_handle<>>& ready) {
+        while (head && head->try_complete()) {
+            ready.push_back(head->waiter);
+            head = head->next;
+            if (!head) tail = nullptr;
+        }
+    }
+};
+
+struct SocketState {
+    int fd;
+    Reactor* reactor;
+    std::mutex mutex;
+    OperationQueue readers;  // accept, recv
+    OperationQueue writers;  // connect, send
+
+    // The reactor's list of registered sockets, under its mutex
+    SocketState* previous = nullptr;
+    SocketState* next = nullptr;
+};
+
+}  // namespace detail
+
+// ============================================================================
+// Reactor - One epoll loop resuming coroutines whose sockets became ready
+// ============================================================================
+
+class Reactor {
+public:
+    Reactor() {
+        epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) throw std::system_error(errno, std::generic_category(), "epoll_create1");
+
+        wakeup_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;  // Marks the wakeup eventfd
+        if (wakeup_fd_ < 0 || ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) < 0) {
+            int error = errno;
+            if (wakeup_fd_ >= 0) ::close(wakeup_fd_);
+            ::close(epoll_fd_);
+            throw std::system_error(error, std::generic_category(), "reactor wakeup");
+        }
+
+        worker_ = std::thread([this] { run(); });
+    }
+
+    ~Reactor() {
+        stopping_.store(true, std::memory_order_release);
+        std::uint64_t one = 1;
+        [[maybe_unused]] auto written = ::write(wakeup_fd_, &one, sizeof one);
+        worker_.join();
+
+        for (auto* state : retired_) delete state;
+        ::close(wakeup_fd_);
+        ::close(epoll_fd_);
+    }
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    // Process-wide reactor used by Socket by default
+    static Reactor& instance() {
+        static Reactor reactor;
+        return reactor;
+    }
+
+    // Registers `fd` for edge-triggered readiness in both directions
+    detail::SocketState* add(int fd) {
+        auto* state = new detail::SocketState{fd, this, {}, {}, {}};
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = state;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            int error = errno;
+            delete state;
+            throw std::system_error(error, std::generic_category(), "epoll_ctl");
+        }
+        std::lock_guard lock(mutex_);
+        state->next = sockets_;
+        if (sockets_) sockets_->previous = state;
+        sockets_ = state;
+        return state;
+    }
+
+    // Unregisters and closes the socket. The reactor may be handling an
+    // event for it right now, so the state is freed on its next iteration.
+    void remove(detail::SocketState* state) {
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, state->fd, nullptr);
+        ::close(state->fd);
+        std::lock_guard lock(mutex_);
+        (state->previous ? state->previous->next : sockets_) = state->next;
+        if (state->next) state->next->previous = state->previous;
+        retired_.push_back(state);
+    }
+
+    // errno of the epoll_wait that stopped the reactor, or 0 while it runs.
+    // Read under a socket's mutex: the reactor sets it before taking them.
+    int failed() const noexcept { return failed_.load(std::memory_order_acquire); }
+
+private:
+    void run() {
+        constexpr int max_events = 256;
+        epoll_event events[max_events];
+        std::vector<std::coroutine_handle<>> ready;
+        std::vector<detail::SocketState*> retired;
+
+        while (!stopping_.load(std::memory_order_acquire)) {
+            {
+                std::lock_guard lock(mutex_);
+                retired.swap(retired_);
+            }
+            for (auto* state : retired) delete state;
+            retired.clear();
+
+            int count = ::epoll_wait(epoll_fd_, events, max_events, -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                // Throwing here would terminate the process
+                fail(errno);
+                return;
+            }
+
+            for (int i = 0; i < count; ++i) {
+                auto* state = static_cast<detail::SocketState*>(events[i].data.ptr);
+                if (!state) {
+                    std::uint64_t value;
+                    [[maybe_unused]] auto read = ::read(wakeup_fd_, &value, sizeof value);
+                    continue;
+                }
+
+                // Errors and hang-ups wake both directions: the retried call
+                // reports them
+                std::uint32_t flags = events[i].events;
+                std::lock_guard lock(state->mutex);
+                if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    state->readers.complete_ready(ready);
+                }
+                if (flags & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+                    state->writers.complete_ready(ready);
+                }
+            }
+
+            // Resumed coroutines may close sockets, which only retires them
+            for (auto handle : ready) handle.resume();
+            ready.clear();
+        }
+    }
+
+    // Stops for good: no more edges will be reported, so every parked
+    // operation finishes with `error`, and await_suspend no longer parks
+    void fail(int error) {
+        failed_.store(error, std::memory_order_release);
+        std::vector<std::coroutine_handle<>> failed;
+        {
+            std::lock_guard lock(mutex_);
+            for (auto* state = sockets_; state; state = state->next) {
+                std::lock_guard state_lock(state->mutex);
+                for (auto* queue : {&state->readers, &state->writers}) {
+                    for (auto* op = queue->head; op; op = op->next) {
+                        op->error = error;
+                        failed.push_back(op->waiter);
+                    }
+                    queue->head = queue->tail = nullptr;
+                }
+            }
+        }
+        // Resumed coroutines may close sockets, which takes the mutex
+        for (auto handle : failed) handle.resume();
+    }
+
+    int epoll_fd_ = -1;
+    int wakeup_fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> failed_{0};
+    std::mutex mutex_;  // Guards sockets_ and retired_
+    detail::SocketState* sockets_ = nullptr;
+    std::vector<detail::SocketState*> retired_;
+    std::thread worker_;  // Declared last: starts after the members it uses
+};
+
+// ============================================================================
+// SocketAddress - An IPv4 or Unix domain socket address
+// ============================================================================
+
+struct SocketAddress {
+    sockaddr_storage storage{};
+    socklen_t length = 0;
+
+    // Throws std::invalid_argument if `host` is not a dotted IPv4 address
+    static SocketAddress ipv4(const char* host, std::uint16_t port) {
+        SocketAddress address;
+        auto* in = reinterpret_cast<sockaddr_in*>(&address.storage);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        if (::inet_pton(AF_INET, host, &in->sin_addr) != 1) {
+            throw std::invalid_argument(std::string("not an IPv4 address: ") + host);
+        }
+        address.length = sizeof(sockaddr_in);
+        return address;
+    }
+
+    // Throws std::invalid_argument if `path` does not fit in sun_path
+    static SocketAddress unix_path(const std::string& path) {
+        SocketAddress address;
+        auto* un = reinterpret_cast<sockaddr_un*>(&address.storage);
+        if (path.size() >= sizeof un->sun_path) {
+            throw std::invalid_argument("unix socket path too long: " + path);
+        }
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+        address.length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+        return address;
+    }
+
+    int family() const { return storage.ss_family; }
+
+    // 0 for Unix domain addresses
+    std::uint16_t port() const {
+        if (family() != AF_INET) return 0;
+        return ntohs(reinterpret_cast<const sockaddr_in*>(&storage)->sin_port);
+    }
+
+    const sockaddr* get() const { return reinterpret_cast<const sockaddr*>(&storage); }
+};
+
+namespace detail {
+
+template<typename Op>
+class SocketAwaiter;
+struct AcceptOperation;
+struct ConnectOperation;
+struct RecvOperation;
+struct SendOperation;
+
+}  // namespace detail
+
+// ============================================================================
+// Socket - A non-blocking socket registered with a Reactor
+// ============================================================================
+
+class Socket {
+public:
+    Socket() = default;
+
+    // Takes ownership of `fd`, makes it non-blocking and registers it
+    Socket(int fd, Reactor& reactor) {
+        int flags = ::fcntl(fd, F_GETFL);
+        if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "fcntl");
+        }
+        try {
+            state_ = reactor.add(fd);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    ~Socket() { close(); }
+
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+
+    Socket(Socket&& other) noexcept : state_(std::exchange(other.state_, nullptr)) {}
+
+    Socket& operator=(Socket&& other) noexcept {
+        if (this != &other) {
+            close();
+            state_ = std::exchange(other.state_, nullptr);
+        }
+        return *this;
+    }
+
+    // Bound and listening. A Unix domain path must not exist yet.
+    static Socket listen(const SocketAddress& address, int backlog = SOMAXCONN,
+                         Reactor& reactor = Reactor::instance()) {
+        Socket socket = open(address.family(), reactor);
+        int yes = 1;
+        if (address.family() == AF_INET) {
+            ::setsockopt(socket.native_handle(), SOL_SOCKET, SO_REUSEADDR, &yes, sizeof yes);
+        }
+        if (::bind(socket.native_handle(), address.get(), address.length) < 0) {
+            throw std::system_error(errno, std::generic_category(), "bind");
+        }
+        if (::listen(socket.native_handle(), backlog) < 0) {
+            throw std::system_error(errno, std::generic_category(), "listen");
+        }
+        return socket;
+    }
+
+    // co_await gives the connected Socket
+    static detail::SocketAwaiter<detail::ConnectOperation> connect(const SocketAddress& address,
+                                                                   Reactor& reactor = Reactor::instance());
+
+    // co_await gives the accepted Socket, on the same reactor
+    detail::SocketAwaiter<detail::AcceptOperation> accept();
+
+    // co_await gives the number of bytes received; 0 once the peer has
+    // shut down its side
+    detail::SocketAwaiter<detail::RecvOperation> recv(std::span<std::byte> buffer);
+
+    // co_await gives the number of bytes sent, which may be fewer than
+    // data.size()
+    detail::SocketAwaiter<detail::SendOperation> send(std::span<const std::byte> data);
+
+    // The address a listening socket ended up bound to (to learn the port
+    // picked for port 0)
+    SocketAddress local_address() const {
+        SocketAddress address;
+        address.length = sizeof address.storage;
+        if (::getsockname(native_handle(), reinterpret_cast<sockaddr*>(&address.storage), &address.length) < 0) {
+            throw std::system_error(errno, std::generic_category(), "getsockname");
+        }
+        return address;
+    }
+
+    void close() {
+        if (state_) state_->reactor->remove(std::exchange(state_, nullptr));
+    }
+
+    explicit operator bool() const noexcept { return state_ != nullptr; }
+    int native_handle() const noexcept { return state_ ? state_->fd : -1; }
+
+private:
+    static Socket open(int family, Reactor& reactor) {
+        int fd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "socket");
+        Socket socket(fd, reactor);
+        if (family == AF_INET) {
+            int yes = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof yes);
+        }
+        return socket;
+    }
+
+    detail::SocketState* state_ = nullptr;
+
+    template<typename Op>
+    friend class detail::SocketAwaiter;
+};
+
+namespace detail {
+
+// The fast path runs in await_ready; await_suspend retries under the socket
+// lock before parking, so a readiness edge in between cannot be missed.
+// Unparking on a stop request takes the same lock, so exactly one of the
+// reactor and the stop callback resumes the coroutine.
+template<typename Op>
+class SocketAwaiter {
+public:
+    template<typename... Args>
+    explicit SocketAwaiter(SocketState* state, Args&&... args) : state_(state), op_{std::forward<Args>(args)...} {}
+
+    bool await_ready() { return op_.try_complete(); }
+
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle) {
+        op_.waiter = handle;
+        std::stop_token token = stop_token_of(handle);
+        // Registered before parking: a stop requested in between is seen
+        // by the check below, under the lock
+        if (token.stop_possible()) on_stop_.emplace(token, CancelOnStop{this});
+
+        std::lock_guard lock(state_->mutex);
+        if (token.stop_requested()) {
+            op_.error = ECANCELED;
+            return false;
+        }
+        if (op_.try_complete()) return false;
+        if (int error = state_->reactor->failed()) {
+            op_.error = error;  // Nothing would resume it
+            return false;
+        }
+        queue().push(&op_);
+        return true;
+    }
+
+    decltype(auto) await_resume() {
+        on_stop_.reset();
+        return op_.result();
+    }
+
+private:
+    struct CancelOnStop {
+        SocketAwaiter* self;
+
+        void operator()() const noexcept {
+            {
+                std::lock_guard lock(self->state_->mutex);
+                if (!self->queue().remove(&self->op_)) return;  // The reactor has it
+                self->op_.error = ECANCELED;
+            }
+            self->op_.waiter.resume();
+        }
+    };
+
+    OperationQueue& queue() { return Op::reads ? state_->readers : state_->writers; }
+
+    SocketState* state_;
+    Op op_;
+    std::optional<std::stop_callback<CancelOnStop>> on_stop_;
+};
+
+// EINTR is retried; anything but EAGAIN finishes the operation
+inline bool would_block(int error) {
+    return error == EAGAIN || error == EWOULDBLOCK;
+}
+
+struct RecvOperation final : SocketOperation {
+    static constexpr bool reads = true;
+
+    RecvOperation(int fd, std::span<std::byte> buffer) : fd(fd), buffer(buffer) {}
+
+    bool try_complete() override {
+        ssize_t n;
+        do {
+            n = ::recv(fd, buffer.data(), buffer.size(), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0 && would_block(errno)) return false;
+        count = n;
+        error = n < 0 ? errno : 0;
+        return true;
+    }
+
+    std::size_t result() const {
+        if (error) throw std::system_error(error, std::generic_category(), "recv");
+        return static_cast<std::size_t>(count);
+    }
+
+    int fd;
+    std::span<std::byte> buffer;
+    ssize_t count = 0;
+};
+
+struct SendOperation final : SocketOperation {
+    static constexpr bool reads = false;
+
+    SendOperation(int fd, std::span<const std::byte> data) : fd(fd), data(data) {}
+
+    bool try_complete() override {
+        ssize_t n;
+        do {
+            n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0 && would_block(errno)) return false;
+        count = n;
+        error = n < 0 ? errno : 0;
+        return true;
+    }
+
+    std::size_t result() const {
+        if (error) throw std::system_error(error, std::generic_category(), "send");
+        return static_cast<std::size_t>(count);
+    }
+
+    int fd;
+    std::span<const std::byte> data;
+    ssize_t count = 0;
+};
+
+struct AcceptOperation final : SocketOperation {
+    static constexpr bool reads = true;
+
+    AcceptOperation(int fd, Reactor& reactor) : fd(fd), reactor(&reactor) {}
+
+    bool try_complete() override {
+        do {
+            accepted = ::accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        } while (accepted < 0 && (errno == EINTR || errno == ECONNABORTED));
+        if (accepted < 0 && would_block(errno)) return false;
+        error = accepted < 0 ? errno : 0;
+        return true;
+    }
+
+    Socket result() {
+        if (error) throw std::system_error(error, std::generic_category(), "accept");
+        // Fails harmlessly on Unix domain sockets
+        int yes = 1;
+        ::setsockopt(accepted, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof yes);
+        return Socket(std::exchange(accepted, -1), *reactor);
+    }
+
+    int fd;
+    Reactor* reactor;
+    int accepted = -1;
+};
+
+// Owns the socket being connected until co_await hands it out
+struct ConnectOperation final : SocketOperation {
+    static constexpr bool reads = false;
+
+    ConnectOperation(Socket&& socket, const SocketAddress& address)
+        : socket(std::move(socket)), address(address) {}
+
+    // connect() again reports progress: EALREADY while pending, EISCONN
+    // once done, or the error that ended the attempt
+    bool try_complete() override {
+        int rc;
+        do {
+            rc = ::connect(socket.native_handle(), address.get(), address.length);
+        } while (rc < 0 && errno == EINTR);
+        if (rc == 0 || errno == EISCONN) {
+            error = 0;
+            return true;
+        }
+        if (errno == EINPROGRESS || errno == EALREADY || would_block(errno)) return false;
+        error = errno;
+        return true;
+    }
+
+    Socket result() {
+        if (error) throw std::system_error(error, std::generic_category(), "connect");
+        return std::move(socket);
+    }
+
+    Socket socket;
+    SocketAddress address;
+};
+
+}  // namespace detail
+
+inline detail::SocketAwaiter<detail::ConnectOperation> Socket::connect(const SocketAddress& address,
+                                                                       Reactor& reactor) {
+    Socket socket = open(address.family(), reactor);
+    detail::SocketState* state = socket.state_;
+    return detail::SocketAwaiter<detail::ConnectOperation>{state, std::move(socket), address};
+}
+
+inline detail::SocketAwaiter<detail::AcceptOperation> Socket::accept() {
+    return detail::SocketAwaiter<detail::AcceptOperation>{state_, state_->fd, *state_->reactor};
+}
+
+inline detail::SocketAwaiter<detail::RecvOperation> Socket::recv(std::span<std::byte> buffer) {
+    return detail::SocketAwaiter<detail::RecvOperation>{state_, state_->fd, buffer};
+}
+
+inline detail::SocketAwaiter<detail::SendOperation> Socket::send(std::span<const std::byte> data) {
+    return detail::SocketAwaiter<detail::SendOperation>{state_, state_->fd, data};
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "awaitable_traits.h"
+#include "frame_allocator.h"
+
+// ============================================================================
+// sync_wait - Block a plain thread until an awaitable completes
+// ============================================================================
+//
+//   int answer = sync_wait(compute_answer());
+//   auto [a, b] = sync_wait(when_all(fetch_a(), fetch_b()));
+//
+// The awaitable is co_await'ed from a small helper coroutine. Whatever thread
+// finishes the awaited work resumes that helper, which publishes the result
+// and wakes the caller parked on a condition variable. The caller never
+// resumes anything itself, so it cannot race with a timer or a scheduler
+// worker that is about to resume the same coroutine. A void awaitable makes
+// sync_wait return void.
+
+namespace detail {
+
+// Lives on the waiting thread's stack. The completer signals while holding
+// the mutex, so the waiter cannot return (and pop the event) before the
+// completer is done with it.
+class SyncWaitEvent {
+public:
+    void set() noexcept {
+        std::lock_guard lock(mutex_);
+        done_ = true;
+        ready_.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock lock(mutex_);
+        ready_.wait(lock, [this] { return done_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool done_ = false;
+};
+
+template<typename Result>
+struct SyncWaitResult {
+    std::optional<Result> result;
+
+    template<typename U>
+    void return_value(U&& value) {
+        result.emplace(std::forward<U>(value));
+    }
+
+    Result take() { return std::move(*result); }
+};
+
+template<>
+struct SyncWaitResult<void> {
+    void return_void() noexcept {}
+    void take() noexcept {}
+};
+
+template<typename Result>
+struct SyncWaitTask {
+    struct promise_type : PooledFramePromise, SyncWaitResult<Result> {
+        SyncWaitEvent* done = nullptr;
+        std::exception_ptr exception;
+
+        SyncWaitTask get_return_object() {
+            return SyncWaitTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                // The waiting thread may destroy this frame as soon as the
+                // event is set, so nothing in the frame is touched after
+                h.promise().done->set();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit SyncWaitTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    SyncWaitTask(const SyncWaitTask&) = delete;
+    SyncWaitTask& operator=(const SyncWaitTask&) = delete;
+    ~SyncWaitTask() {
+        if (handle) handle.destroy();
+    }
+
+    Result run() {
+        SyncWaitEvent done;
+        handle.promise().done = &done;
+        handle.resume();
+        done.wait();
+
+        auto& promise = handle.promise();
+        if (promise.exception) {
+            std::rethrow_exception(promise.exception);
+        }
+        return promise.take();
+    }
+};
+
+template<typename Awaitable>
+using sync_wait_result_t = std::remove_cvref_t<await_result_t<Awaitable&&>>;
+
+template<typename Awaitable>
+    requires std::is_void_v<sync_wait_result_t<Awaitable>>
+SyncWaitTask<void> make_sync_wait_task(Awaitable&& awaitable) {
+    if constexpr (requires { std::forward<Awaitable>(awaitable).operator co_await(); }) {
+        co_await std::forward<Awaitable>(awaitable);
+    } else {
+        co_await awaitable;  // In place, as below
+    }
+}
+
+template<typename Awaitable>
+    requires(!std::is_void_v<sync_wait_result_t<Awaitable>>)
+SyncWaitTask<sync_wait_result_t<Awaitable>> make_sync_wait_task(Awaitable&& awaitable) {
+    if constexpr (requires { std::forward<Awaitable>(awaitable).operator co_await(); }) {
+        co_return co_await std::forward<Awaitable>(awaitable);
+    } else {
+        // Already an awaiter: await it in place. GCC 12 tries to move an
+        // xvalue awaiter into the frame, which fails for pinned awaiters
+        // such as when_all's.
+        co_return co_await awaitable;
+    }
+}
+
+}  // namespace detail
+
+// Returns the awaited value by value (a copy when the awaitable yields a
+// reference, as co_await on a Task lvalue does)
+template<typename Awaitable>
+auto sync_wait(Awaitable&& awaitable) {
+    return detail::make_sync_wait_task(std::forward<Awaitable>(awaitable)).run();
+}
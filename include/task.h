@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <stop_token>
+#include <utility>
+
+#include "cancellation.h"
+#include "frame_allocator.h"
+#include "sync_wait.h"
+#include "trace.h"
+
+namespace detail {
+
+// ============================================================================
+// State and awaiters shared by Task and LazyTask
+// ============================================================================
+
+template<typename T>
+struct TaskPromiseBase : PooledFramePromise {
+    // Who gets to the rendezvous first: the awaiter parking its
+    // continuation, or the task reaching final_suspend
+    enum class State { not_started, running, awaited, finished };
+
+    explicit TaskPromiseBase(State initial) : state(initial) {}
+
+    T value{};
+    std::exception_ptr exception;
+    std::coroutine_handle<> continuation;
+    std::atomic<State> state;
+    std::stop_token stop_token;  // See cancellation.h
+
+    std::stop_token get_stop_token() const noexcept { return stop_token; }
+
+    // Hands control straight to the awaiting coroutine (symmetric
+    // transfer): no trip through the resumer and no stack growth
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            COROUTINE_TRACE_SUSPEND("final", h.address());
+            auto& promise = h.promise();
+            if (promise.state.exchange(State::finished, std::memory_order_acq_rel) == State::awaited) {
+                return promise.continuation;
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    COROUTINE_TRACE_AWAIT
+
+    void unhandled_exception() {
+        exception = std::current_exception();
+    }
+
+    T& result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return value;
+    }
+};
+
+// co_await on a task: starts it if it has not started yet, otherwise parks
+// the continuation for the task's final_suspend to resume
+template<typename Promise>
+struct TaskAwaiter {
+    std::coroutine_handle<Promise> handle;
+
+    using State = typename Promise::State;
+
+    bool await_ready() const noexcept {
+        return handle.promise().state.load(std::memory_order_acquire) == State::finished;
+    }
+
+    template<typename Awaiting>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Awaiting> awaiting) noexcept {
+        auto& promise = handle.promise();
+        promise.continuation = awaiting;
+
+        if (promise.state.load(std::memory_order_acquire) == State::not_started) {
+            // Not running yet, so nobody else can be reading the token
+            if (!promise.stop_token.stop_possible()) promise.stop_token = stop_token_of(awaiting);
+            promise.state.store(State::awaited, std::memory_order_relaxed);
+            return handle;  // Run the task now; it transfers back when done
+        }
+
+        auto expected = State::running;
+        if (promise.state.compare_exchange_strong(expected, State::awaited,
+                                                  std::memory_order_acq_rel)) {
+            return std::noop_coroutine();
+        }
+        return awaiting;  // Finished meanwhile: carry on immediately
+    }
+
+    decltype(auto) await_resume() { return handle.promise().result(); }
+};
+
+template<typename Promise>
+struct MovingTaskAwaiter : TaskAwaiter<Promise> {
+    auto await_resume() { return std::move(this->handle.promise().result()); }
+};
+
+}  // namespace detail
+
+// ============================================================================
+// Task - Eagerly started computation that produces a single value
+// ============================================================================
+
+template<typename T>
+struct Task {
+    struct promise_type : detail::TaskPromiseBase<T> {
+        using State = typename detail::TaskPromiseBase<T>::State;
+
+        promise_type() : detail::TaskPromiseBase<T>(State::running) {
+            COROUTINE_TRACE_CREATE("Task", trace::frame_id(*this));
+            COROUTINE_TRACE_RESUME(trace::frame_id(*this));
+        }
+
+        // Task<T> f(std::stop_token token, ...) runs with `token`
+        template<typename... Args>
+        explicit promise_type(std::stop_token token, Args&&...) : promise_type() {
+            this->stop_token = std::move(token);
+        }
+
+        ~promise_type() { COROUTINE_TRACE_DESTROY(trace::frame_id(*this)); }
+
+        Task get_return_object() {
+            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_never initial_suspend() { return {}; }  // Start immediately
+
+        void return_value(T v) {
+            COROUTINE_TRACE_EVENT("task.return_value", this, 0);
+            this->value = std::move(v);
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept : handle(other.handle) {
+        other.handle = nullptr;
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = other.handle;
+            other.handle = nullptr;
+        }
+        return *this;
+    }
+
+    // Lets one Task co_await another. The task is already running (eager
+    // start), so the awaiter only parks the continuation; the task resumes
+    // it from its final_suspend.
+    auto operator co_await() & noexcept { return detail::TaskAwaiter<promise_type>{handle}; }
+    auto operator co_await() && noexcept { return detail::MovingTaskAwaiter<promise_type>{{handle}}; }
+
+    // Blocks until the task finishes, on whichever thread that happens
+    T get() {
+        return sync_wait(*this);
+    }
+
+    bool is_ready() const {
+        return handle.promise().state.load(std::memory_order_acquire) ==
+               promise_type::State::finished;
+    }
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// TimerService - Resumes suspended coroutines once their deadline passes
+// ============================================================================
+//
+// One background thread drives a min-heap of deadlines. A pending sleep costs
+// a single heap entry instead of a dedicated OS thread, and registering a
+// timer never creates a thread.
+//
+// Expired coroutines are resumed on the timer thread, so a coroutine that
+// does heavy work after waking should move itself elsewhere (for example by
+// awaiting a scheduler) to keep other timers on time.
+//
+// A timer scheduled through a Timer object can be cancelled. Each Timer
+// remembers its position in the heap, so cancel() takes the entry out
+// right away instead of leaving it to expire.
+
+class TimerService {
+public:
+    using clock = std::chrono::steady_clock;
+
+    TimerService() : worker_([this] { run(); }) {}
+
+    ~TimerService() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_one();
+        worker_.join();
+    }
+
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    // Process-wide service used by sleep_for()
+    static TimerService& instance() {
+        static TimerService service;
+        return service;
+    }
+
+    // Handle for a cancellable timer, usually a member of the awaiter that
+    // sleeps on it. It must stay in place while scheduled.
+    class Timer {
+    public:
+        Timer() = default;
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        friend class TimerService;
+
+        enum class State : std::uint8_t { idle, scheduled, fired, cancelled };
+
+        State state = State::idle;  // Guarded by the service's mutex
+        std::size_t index = 0;      // Heap position while scheduled
+    };
+
+    // Resume `handle` on the timer thread at (or shortly after) `deadline`
+    void schedule(clock::time_point deadline, std::coroutine_handle<> handle) {
+        bool earliest;
+        {
+            std::lock_guard lock(mutex_);
+            earliest = push(Entry{deadline, next_sequence_++, handle, nullptr});
+        }
+        // Only a new earliest deadline changes how long the worker must sleep
+        if (earliest) wakeup_.notify_one();
+    }
+
+    // Same, through `timer`. Returns false, and schedules nothing, if the
+    // timer was cancelled before it could be scheduled.
+    bool schedule(Timer& timer, clock::time_point deadline, std::coroutine_handle<> handle) {
+        bool earliest;
+        {
+            std::lock_guard lock(mutex_);
+            if (timer.state == Timer::State::cancelled) return false;
+            timer.state = Timer::State::scheduled;
+            earliest = push(Entry{deadline, next_sequence_++, handle, &timer});
+        }
+        if (earliest) wakeup_.notify_one();
+        return true;
+    }
+
+    // True if the timer was pending and now never fires: its coroutine
+    // will not be resumed by the service, so the caller must do it. A timer
+    // cancelled before it is scheduled makes schedule() refuse it.
+    bool cancel(Timer& timer) {
+        std::lock_guard lock(mutex_);
+        switch (timer.state) {
+        case Timer::State::scheduled:
+            timer.state = Timer::State::cancelled;
+            erase(timer.index);
+            return true;
+        case Timer::State::idle:
+            timer.state = Timer::State::cancelled;
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    std::size_t pending() const {
+        std::lock_guard lock(mutex_);
+        return heap_.size();
+    }
+
+private:
+    struct Entry {
+        clock::time_point deadline;
+        std::uint64_t sequence;  // Keeps equal deadlines in FIFO order
+        std::coroutine_handle<> handle;
+        Timer* timer;  // Null unless the entry can be cancelled
+    };
+
+    static bool earlier(const Entry& a, const Entry& b) {
+        if (a.deadline != b.deadline) return a.deadline < b.deadline;
+        return a.sequence < b.sequence;
+    }
+
+    // A binary min-heap kept by hand rather than in std::priority_queue,
+    // so entries can report where they are and be erased from the middle
+
+    void place(std::size_t index, Entry entry) {
+        if (entry.timer) entry.timer->index = index;
+        heap_[index] = std::move(entry);
+    }
+
+    void sift_up(std::size_t index) {
+        Entry entry = heap_[index];
+        while (index > 0) {
+            std::size_t parent = (index - 1) / 2;
+            if (!earlier(entry, heap_[parent])) break;
+            place(index, heap_[parent]);
+            index = parent;
+        }
+        place(index, entry);
+    }
+
+    void sift_down(std::size_t index) {
+        Entry entry = heap_[index];
+        const std::size_t size = heap_.size();
+        while (true) {
+            std::size_t child = 2 * index + 1;
+            if (child >= size) break;
+            if (child + 1 < size && earlier(heap_[child + 1], heap_[child])) ++child;
+            if (!earlier(heap_[child], entry)) break;
+            place(index, heap_[child]);
+            index = child;
+        }
+        place(index, entry);
+    }
+
+    // True if the new entry is the earliest
+    bool push(Entry entry) {
+        heap_.push_back(entry);
+        sift_up(heap_.size() - 1);
+        return heap_.front().sequence == entry.sequence;
+    }
+
+    void erase(std::size_t index) {
+        Entry last = heap_.back();
+        heap_.pop_back();
+        if (index == heap_.size()) return;
+        place(index, last);
+        if (index > 0 && earlier(heap_[index], heap_[(index - 1) / 2])) {
+            sift_up(index);
+        } else {
+            sift_down(index);
+        }
+    }
+
+    void run() {
+        std::vector<std::coroutine_handle<>> due;
+        std::unique_lock lock(mutex_);
+
+        while (!stopping_) {
+            if (heap_.empty()) {
+                wakeup_.wait(lock);
+                continue;
+            }
+
+            auto next_deadline = heap_.front().deadline;
+            if (clock::now() < next_deadline) {
+                wakeup_.wait_until(lock, next_deadline);
+                continue;
+            }
+
+            // Collect everything that expired, then resume without the lock
+            // so woken coroutines can register new timers
+            auto now = clock::now();
+            while (!heap_.empty() && heap_.front().deadline <= now) {
+                Entry& entry = heap_.front();
+                if (entry.timer) entry.timer->state = Timer::State::fired;
+                due.push_back(entry.handle);
+                erase(0);
+            }
+
+            lock.unlock();
+            for (auto handle : due) {
+                handle.resume();
+            }
+            due.clear();
+            lock.lock();
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::vector<Entry> heap_;
+    std::uint64_t next_sequence_ = 0;
+    bool stopping_ = false;
+    std::thread worker_;  // Declared last: starts after the members it uses
+};
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "awaitable_traits.h"
+
+// ============================================================================
+// Tracing - Compile-time switchable event log for coroutine hooks
+// ============================================================================
+//
+// Promise and awaiter hooks call COROUTINE_TRACE_EVENT instead of writing to
+// std::cout. Tracing is selected at compile time:
+//
+//   COROUTINE_TRACE=0 (default)  the macro expands to nothing; its arguments
+//                                are not even evaluated
+//   COROUTINE_TRACE=1            events go to a per-thread ring buffer
+//
+// Recording never locks and never calls into iostreams: each thread owns a
+// fixed-size ring and is its only writer, so an event is a clock read and a
+// few relaxed stores. When a ring is full the oldest events are overwritten.
+// trace::snapshot() collects what is left from every thread.
+//
+// Event names must be string literals (or otherwise outlive the program);
+// only the pointer is stored.
+//
+// Besides free-form events, Generator, Task and LazyTask record their own
+// lifecycle: create, every resume and suspend, and destroy, keyed by the
+// frame address. chrome_trace.h turns a snapshot into a timeline.
+
+#ifndef COROUTINE_TRACE
+#define COROUTINE_TRACE 0
+#endif
+
+#ifndef COROUTINE_TRACE_BUFFER_EVENTS
+#define COROUTINE_TRACE_BUFFER_EVENTS 4096
+#endif
+
+namespace trace {
+
+inline constexpr bool enabled = COROUTINE_TRACE != 0;
+
+enum class Kind : std::uint8_t {
+    instant,  // Free-form event from COROUTINE_TRACE_EVENT
+    create,   // name: the coroutine type
+    resume,
+    suspend,  // name: why (yield, co_await, final, ...)
+    destroy,
+};
+
+struct Event {
+    std::uint64_t time_ns;  // steady_clock, since its epoch
+    Kind kind;
+    const char* name;
+    const void* coroutine;  // Frame address, used as an id
+    std::int64_t value;
+    std::uint32_t thread;  // Small per-thread index, in order of first event
+};
+
+// The id lifecycle events use for the coroutine that owns `promise`
+template<typename Promise>
+const void* frame_id(Promise& promise) noexcept {
+    return std::coroutine_handle<Promise>::from_promise(promise).address();
+}
+
+namespace detail {
+
+class ThreadBuffer {
+public:
+    static constexpr std::size_t capacity = COROUTINE_TRACE_BUFFER_EVENTS;
+    static_assert((capacity & (capacity - 1)) == 0, "trace buffer size must be a power of two");
+
+    explicit ThreadBuffer(std::uint32_t thread) : thread_(thread) {}
+
+    // Owning thread only
+    void record(Kind kind, const char* name, const void* coroutine, std::int64_t value) noexcept {
+        std::uint64_t index = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[index & (capacity - 1)];
+        slot.time_ns.store(now_ns(), std::memory_order_relaxed);
+        slot.kind.store(kind, std::memory_order_relaxed);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.coroutine.store(coroutine, std::memory_order_relaxed);
+        slot.value.store(value, std::memory_order_relaxed);
+        head_.store(index + 1, std::memory_order_release);
+    }
+
+    // Any thread. Events the owner overwrote while they were being copied
+    // are dropped rather than returned torn.
+    void copy_to(std::vector<Event>& out) const {
+        std::uint64_t head = head_.load(std::memory_order_acquire);
+        std::uint64_t first = head > capacity ? head - capacity : 0;
+
+        std::size_t start = out.size();
+        for (std::uint64_t i = first; i < head; ++i) {
+            const Slot& slot = slots_[i & (capacity - 1)];
+            out.push_back(Event{slot.time_ns.load(std::memory_order_relaxed),
+                                slot.kind.load(std::memory_order_relaxed),
+                                slot.name.load(std::memory_order_relaxed),
+                                slot.coroutine.load(std::memory_order_relaxed),
+                                slot.value.load(std::memory_order_relaxed), thread_});
+        }
+
+        // The owner may already be writing event `now`, which reuses the
+        // slot of event `now - capacity`
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::uint64_t now = head_.load(std::memory_order_relaxed);
+        std::uint64_t valid_from = now + 1 > capacity ? now + 1 - capacity : 0;
+        if (valid_from > first) {
+            std::size_t torn = static_cast<std::size_t>(std::min(valid_from, head) - first);
+            out.erase(out.begin() + static_cast<std::ptrdiff_t>(start),
+                      out.begin() + static_cast<std::ptrdiff_t>(start + torn));
+        }
+    }
+
+    static std::uint64_t now_ns() noexcept {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> time_ns{0};
+        std::atomic<Kind> kind{Kind::instant};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<const void*> coroutine{nullptr};
+        std::atomic<std::int64_t> value{0};
+    };
+
+    std::atomic<std::uint64_t> head_{0};
+    std::uint32_t thread_;
+    std::array<Slot, capacity> slots_;
+};
+
+// Buffers stay registered after their thread exits, so its events can still
+// be collected
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadBuffer& add() {
+        std::lock_guard lock(mutex_);
+        buffers_.push_back(std::make_unique<ThreadBuffer>(static_cast<std::uint32_t>(buffers_.size())));
+        return *buffers_.back();
+    }
+
+    std::vector<Event> collect() {
+        std::vector<Event> events;
+        std::lock_guard lock(mutex_);
+        for (const auto& buffer : buffers_) buffer->copy_to(events);
+        return events;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+inline ThreadBuffer& local_buffer() {
+    // Registration takes a lock once per thread; every later event is lock-free
+    thread_local ThreadBuffer& buffer = Registry::instance().add();
+    return buffer;
+}
+
+}  // namespace detail
+
+inline void record(Kind kind, const char* name, const void* coroutine, std::int64_t value = 0) noexcept {
+    if constexpr (enabled) detail::local_buffer().record(kind, name, coroutine, value);
+}
+
+// Wraps every co_await in a traced promise (see COROUTINE_TRACE_AWAIT) so
+// the awaiting coroutine's suspend and resume are recorded whatever it awaits
+template<typename Awaiter>
+struct TracedAwaiter {
+    Awaiter awaiter;
+    std::coroutine_handle<> waiting;
+
+    bool await_ready() { return awaiter.await_ready(); }
+
+    template<typename Promise>
+    decltype(auto) await_suspend(std::coroutine_handle<Promise> h) {
+        // Record first: once the inner awaiter has the handle, another
+        // thread may resume and even destroy the frame
+        waiting = h;
+        record(Kind::suspend, "co_await", h.address());
+        return awaiter.await_suspend(h);
+    }
+
+    decltype(auto) await_resume() {
+        if (waiting) record(Kind::resume, "resume", waiting.address());
+        return awaiter.await_resume();
+    }
+};
+
+template<typename Awaitable>
+auto traced(Awaitable&& awaitable) {
+    return TracedAwaiter<::detail::awaiter_t<Awaitable>>{
+        ::detail::get_awaiter(std::forward<Awaitable>(awaitable)), {}};
+}
+
+// Every retained event from every thread, oldest first. Empty when tracing
+// is compiled out.
+inline std::vector<Event> snapshot() {
+    if constexpr (!enabled) return {};
+    auto events = detail::Registry::instance().collect();
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event& a, const Event& b) { return a.time_ns < b.time_ns; });
+    return events;
+}
+
+}  // namespace trace
+
+#if COROUTINE_TRACE
+#define COROUTINE_TRACE_EVENT(name, coroutine, value) \
+    ::trace::record(::trace::Kind::instant, (name), (coroutine), (value))
+#define COROUTINE_TRACE_CREATE(name, coroutine) ::trace::record(::trace::Kind::create, (name), (coroutine))
+#define COROUTINE_TRACE_RESUME(coroutine) ::trace::record(::trace::Kind::resume, "resume", (coroutine))
+#define COROUTINE_TRACE_SUSPEND(reason, coroutine) ::trace::record(::trace::Kind::suspend, (reason), (coroutine))
+#define COROUTINE_TRACE_DESTROY(coroutine) ::trace::record(::trace::Kind::destroy, "destroy", (coroutine))
+
+// Inside a promise type: routes every co_await through trace::traced. A
+// promise with an await_transform member changes how all of its co_await
+// expressions are looked up, so this only exists when tracing is on.
+#define COROUTINE_TRACE_AWAIT                                      \
+    template<typename Awaitable>                                   \
+    auto await_transform(Awaitable&& awaitable) {                  \
+        return ::trace::traced(std::forward<Awaitable>(awaitable)); \
+    }
+#else
+#define COROUTINE_TRACE_EVENT(name, coroutine, value) ((void)0)
+#define COROUTINE_TRACE_CREATE(name, coroutine) ((void)0)
+#define COROUTINE_TRACE_RESUME(coroutine) ((void)0)
+#define COROUTINE_TRACE_SUSPEND(reason, coroutine) ((void)0)
+#define COROUTINE_TRACE_DESTROY(coroutine) ((void)0)
+#define COROUTINE_TRACE_AWAIT
+#endif
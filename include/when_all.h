@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <stop_token>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "awaitable_traits.h"
+#include "cancellation.h"
+#include "frame_allocator.h"
+
+// ============================================================================
+// when_all - Await several tasks at once and collect all their results
+// ============================================================================
+//
+//   auto [a, b] = co_await when_all(fetch_a(), fetch_b());           // tuple
+//   std::vector<int> all = co_await when_all(std::move(tasks));      // vector
+//
+// Each task (Task, LazyTask or any awaitable producing a value) is moved into
+// a small child coroutine. The children are started one after another on
+// the awaiting thread and run concurrently whenever they suspend, for
+// example on a timer or a scheduler. Completion is counted down on one
+// atomic; the child that finishes last resumes the awaiting coroutine by
+// symmetric transfer. If a task throws, co_await rethrows the exception of
+// the first such task in argument order.
+
+namespace detail {
+
+// Counts down once per child plus once for the awaiting coroutine itself,
+// so whichever arrives last knows it has to resume the continuation
+class WhenAllLatch {
+public:
+    explicit WhenAllLatch(std::size_t children) : count_(children + 1) {}
+
+    // Called by the awaiting coroutine after starting every child. Returns
+    // false when all children already finished and it should not suspend.
+    bool try_await(std::coroutine_handle<> continuation) noexcept {
+        continuation_ = continuation;
+        return count_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+    }
+
+    // Called by each child as it finishes
+    std::coroutine_handle<> notify_completed() noexcept {
+        if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            return continuation_;
+        }
+        return std::noop_coroutine();
+    }
+
+private:
+    std::atomic<std::size_t> count_;
+    std::coroutine_handle<> continuation_;
+};
+
+template<typename Result>
+struct WhenAllChild {
+    struct promise_type : PooledFramePromise {
+        WhenAllLatch* latch = nullptr;
+        std::optional<Result> result;
+        std::exception_ptr exception;
+        std::stop_token stop_token;  // The awaiting coroutine's, passed on to the task
+
+        std::stop_token get_stop_token() const noexcept { return stop_token; }
+
+        WhenAllChild get_return_object() {
+            return WhenAllChild{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                return h.promise().latch->notify_completed();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        template<typename U>
+        void return_value(U&& value) {
+            result.emplace(std::forward<U>(value));
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit WhenAllChild(std::coroutine_handle<promise_type> h) : handle(h) {}
+    WhenAllChild(WhenAllChild&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    WhenAllChild& operator=(WhenAllChild&&) = delete;
+    ~WhenAllChild() {
+        if (handle) handle.destroy();
+    }
+
+    void start(WhenAllLatch& latch, const std::stop_token& stop_token) {
+        handle.promise().latch = &latch;
+        handle.promise().stop_token = stop_token;
+        handle.resume();
+    }
+
+    Result take() {
+        auto& promise = handle.promise();
+        if (promise.exception) {
+            std::rethrow_exception(promise.exception);
+        }
+        return std::move(*promise.result);
+    }
+};
+
+template<typename Awaitable>
+using when_all_result_t = std::remove_cvref_t<await_result_t<Awaitable>>;
+
+template<typename Awaitable>
+WhenAllChild<when_all_result_t<Awaitable>> make_when_all_child(Awaitable awaitable) {
+    co_return co_await std::move(awaitable);
+}
+
+template<typename... Results>
+class WhenAllTuple {
+public:
+    explicit WhenAllTuple(WhenAllChild<Results>... children)
+        : children_(std::move(children)...), latch_(sizeof...(Results)) {}
+
+    bool await_ready() const noexcept { return sizeof...(Results) == 0; }
+
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> awaiting) {
+        std::stop_token stop_token = stop_token_of(awaiting);
+        std::apply([&](auto&... child) { (child.start(latch_, stop_token), ...); }, children_);
+        return latch_.try_await(awaiting);
+    }
+
+    std::tuple<Results...> await_resume() {
+        return std::apply([](auto&... child) { return std::tuple<Results...>{child.take()...}; },
+                          children_);
+    }
+
+private:
+    std::tuple<WhenAllChild<Results>...> children_;
+    WhenAllLatch latch_;
+};
+
+template<typename Result>
+class WhenAllVector {
+public:
+    explicit WhenAllVector(std::vector<WhenAllChild<Result>> children)
+        : children_(std::move(children)), latch_(children_.size()) {}
+
+    bool await_ready() const noexcept { return children_.empty(); }
+
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> awaiting) {
+        std::stop_token stop_token = stop_token_of(awaiting);
+        for (auto& child : children_) {
+            child.start(latch_, stop_token);
+        }
+        return latch_.try_await(awaiting);
+    }
+
+    std::vector<Result> await_resume() {
+        std::vector<Result> results;
+        results.reserve(children_.size());
+        for (auto& child : children_) {
+            results.push_back(child.take());
+        }
+        return results;
+    }
+
+private:
+    std::vector<WhenAllChild<Result>> children_;
+    WhenAllLatch latch_;
+};
+
+}  // namespace detail
+
+// Tasks are taken by value: pass temporaries or std::move them in
+template<typename... Awaitables>
+auto when_all(Awaitables... awaitables) {
+    return detail::WhenAllTuple<detail::when_all_result_t<Awaitables>...>(
+        detail::make_when_all_child(std::move(awaitables))...);
+}
+
+template<typename Awaitable>
+auto when_all(std::vector<Awaitable> awaitables) {
+    using Result = detail::when_all_result_t<Awaitable>;
+
+    std::vector<detail::WhenAllChild<Result>> children;
+    children.reserve(awaitables.size());
+    for (auto& awaitable : awaitables) {
+        children.push_back(detail::make_when_all_child(std::move(awaitable)));
+    }
+    return detail::WhenAllVector<Result>(std::move(children));
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "awaitable_traits.h"
+#include "cancellation.h"
+#include "frame_allocator.h"
+
+// ============================================================================
+// when_any - Await several tasks and continue with the first one to finish
+// ============================================================================
+//
+//   auto first = co_await when_any(std::move(replicas));
+//   use(first.index, first.value);
+//
+// All tasks must produce the same result type. The awaiting coroutine
+// resumes as soon as one task finishes (or throws, in which case co_await
+// rethrows). The others are asked to stop through the stop token when_any
+// gives them (see cancellation.h), and that token is also stopped when the
+// awaiting coroutine's own token is. The winner resumes the awaiting
+// coroutine first and requests stop only once that returns control, so
+// stop callbacks (cancelled timers, unparked sockets) and whatever losers
+// they resume never delay it. If the awaiting coroutine has not finished
+// starting the tasks when the winner finishes, stop is requested at once.
+// Losers that do not check the token keep
+// running to completion in the background: each task is owned by a
+// detached child coroutine that frees itself, so nothing has to wait for
+// the losers.
+
+template<typename T>
+struct WhenAnyResult {
+    std::size_t index;
+    T value;
+};
+
+namespace detail {
+
+template<typename Result>
+class WhenAnyState {
+public:
+    // The first child to finish wins; later ones are ignored
+    bool try_win() noexcept {
+        return !decided_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    // Two parties arrive: the winner and the awaiting coroutine once it has
+    // started every child. The second one to arrive resumes the awaiter.
+    bool try_await(std::coroutine_handle<> continuation) noexcept {
+        continuation_ = continuation;
+        return arrivals_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+    }
+
+    // True if the awaiting coroutine is parked and the winner must resume it
+    bool notify_won() noexcept {
+        return arrivals_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    std::coroutine_handle<> continuation() const noexcept { return continuation_; }
+
+    WhenAnyResult<Result> take() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*result);
+    }
+
+    std::optional<WhenAnyResult<Result>> result;
+    std::exception_ptr exception;
+
+    // Stopped once there is a winner, or when the awaiting coroutine is
+    // cancelled
+    std::stop_source stop;
+
+    void link_stop(const std::stop_token& parent) {
+        if (parent.stop_possible()) on_parent_stop_.emplace(parent, StopChildren{&stop});
+    }
+
+private:
+    struct StopChildren {
+        std::stop_source* source;
+        void operator()() const noexcept { source->request_stop(); }
+    };
+
+    std::optional<std::stop_callback<StopChildren>> on_parent_stop_;
+    std::atomic<bool> decided_{false};
+    std::atomic<int> arrivals_{2};
+    std::coroutine_handle<> continuation_;
+};
+
+template<typename Result>
+struct WhenAnyChild {
+    struct promise_type : PooledFramePromise {
+        std::shared_ptr<WhenAnyState<Result>> state;
+        std::size_t index;
+        bool won = false;
+
+        template<typename Awaitable>
+        promise_type(const std::shared_ptr<WhenAnyState<Result>>& s, std::size_t i, Awaitable&)
+            : state(s), index(i) {}
+
+        WhenAnyChild get_return_object() { return {}; }
+
+        std::stop_token get_stop_token() const noexcept { return state->stop.get_token(); }
+
+        // Frees the frame. A winner that arrives second resumes the
+        // awaiting coroutine, then asks the losers to stop.
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                bool won = h.promise().won;
+                // Keeps the stop source alive while the awaiting coroutine runs
+                std::shared_ptr<WhenAnyState<Result>> state = std::move(h.promise().state);
+                h.destroy();
+                if (!won) return;
+                if (state->notify_won()) state->continuation().resume();
+                state->stop.request_stop();  // Losers that listen finish now
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_never initial_suspend() { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        template<typename U>
+        void return_value(U&& value) {
+            if (state->try_win()) {
+                state->result.emplace(WhenAnyResult<Result>{index, std::forward<U>(value)});
+                won = true;
+            }
+        }
+
+        void unhandled_exception() {
+            if (state->try_win()) {
+                state->exception = std::current_exception();
+                won = true;
+            }
+        }
+    };
+};
+
+template<typename Awaitable>
+using when_any_result_t = std::remove_cvref_t<await_result_t<Awaitable>>;
+
+template<typename Result, typename Awaitable>
+WhenAnyChild<Result> run_when_any_child(std::shared_ptr<WhenAnyState<Result>>, std::size_t,
+                                        Awaitable awaitable) {
+    // The promise picks up the state and index from the parameters
+    co_return co_await std::move(awaitable);
+}
+
+template<typename Result, typename Container>
+class WhenAnyAwaitable {
+public:
+    explicit WhenAnyAwaitable(Container awaitables)
+        : awaitables_(std::move(awaitables)), state_(std::make_shared<WhenAnyState<Result>>()) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> awaiting) {
+        state_->link_stop(stop_token_of(awaiting));
+        std::size_t index = 0;
+        auto start = [&](auto& awaitable) {
+            run_when_any_child<Result>(state_, index++, std::move(awaitable));
+        };
+        if constexpr (requires { awaitables_.begin(); }) {
+            for (auto& awaitable : awaitables_) start(awaitable);
+        } else {
+            std::apply([&](auto&... awaitable) { (start(awaitable), ...); }, awaitables_);
+        }
+        return state_->try_await(awaiting);
+    }
+
+    WhenAnyResult<Result> await_resume() { return state_->take(); }
+
+private:
+    Container awaitables_;  // Moved-from once the children start
+    std::shared_ptr<WhenAnyState<Result>> state_;
+};
+
+}  // namespace detail
+
+// Tasks are taken by value: pass temporaries or std::move them in
+template<typename First, typename... Rest>
+auto when_any(First first, Rest... rest) {
+    using Result = detail::when_any_result_t<First>;
+    static_assert((std::is_same_v<Result, detail::when_any_result_t<Rest>> && ...),
+                  "when_any needs every task to produce the same type");
+
+    return detail::WhenAnyAwaitable<Result, std::tuple<First, Rest...>>(
+        std::tuple<First, Rest...>(std::move(first), std::move(rest)...));
+}
+
+// Throws std::invalid_argument for an empty vector: with no task to finish
+// first, the awaiting coroutine would never resume
+template<typename Awaitable>
+auto when_any(std::vector<Awaitable> awaitables) {
+    using Result = detail::when_any_result_t<Awaitable>;
+    if (awaitables.empty()) throw std::invalid_argument("when_any needs at least one task");
+    return detail::WhenAnyAwaitable<Result, std::vector<Awaitable>>(std::move(awaitables));
+}
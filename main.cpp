@@ -1,74 +1,34 @@
 #include <coroutine>
 #include <iostream>
-#include <thread>
 #include <chrono>
+#include <fstream>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+#include "async_generator.h"
+#include "async_scope.h"
+#include "batched_generator.h"
+#include "chrome_trace.h"
+#include "generator.h"
+#include "interleave.h"
+#include "lazy_task.h"
+#include "pipeline.h"
+#include "scheduler.h"
+#include "task.h"
+#include "timer_service.h"
+#include "when_all.h"
+#include "when_any.h"
 
 // ============================================================================
 // EXAMPLE 1: Simple Generator - Produces a sequence of values
 // ============================================================================
 
-template<typename T>
-struct Generator {
-    struct promise_type {
-        T current_value;
-        std::exception_ptr exception;
-
-        Generator get_return_object() {
-            return Generator{std::coroutine_handle<promise_type>::from_promise(*this)};
-        }
-
-        std::suspend_always initial_suspend() { return {}; }
-        std::suspend_always final_suspend() noexcept { return {}; }
-
-        std::suspend_always yield_value(T value) {
-            current_value = value;
-            return {};
-        }
-
-        void return_void() {}
-
-        void unhandled_exception() {
-            exception = std::current_exception();
-        }
-    };
-
-    std::coroutine_handle<promise_type> handle;
-
-    Generator(std::coroutine_handle<promise_type> h) : handle(h) {}
-
-    ~Generator() {
-        if (handle) handle.destroy();
-    }
-
-    // Move-only type
-    Generator(const Generator&) = delete;
-    Generator& operator=(const Generator&) = delete;
-
-    Generator(Generator&& other) noexcept : handle(other.handle) {
-        other.handle = nullptr;
-    }
-
-    Generator& operator=(Generator&& other) noexcept {
-        if (this != &other) {
-            if (handle) handle.destroy();
-            handle = other.handle;
-            other.handle = nullptr;
-        }
-        return *this;
-    }
-
-    bool next() {
-        handle.resume();
-        if (handle.promise().exception) {
-            std::rethrow_exception(handle.promise().exception);
-        }
-        return !handle.done();
-    }
-
-    T value() const {
-        return handle.promise().current_value;
-    }
-};
+// Generator<T> (generator.h) suspends at every co_yield and hands the value
+// to the caller; its frame comes from the per-thread frame pool.
 
 // Generates Fibonacci numbers
 Generator<int> fibonacci(int count) {
@@ -103,67 +63,8 @@ Generator<int> range(int start, int end) {
 // EXAMPLE 2: Task - Represents an async computation
 // ============================================================================
 
-template<typename T>
-struct Task {
-    struct promise_type {
-        T value;
-        std::exception_ptr exception;
-
-        Task get_return_object() {
-            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
-        }
-
-        std::suspend_never initial_suspend() { return {}; }  // Start immediately
-        std::suspend_always final_suspend() noexcept { return {}; }
-
-        void return_value(T v) {
-            std::cout << "[Task Promise] Storing return value: " << v << "\n";
-            value = v;
-        }
-
-        void unhandled_exception() {
-            exception = std::current_exception();
-        }
-    };
-
-    std::coroutine_handle<promise_type> handle;
-
-    Task(std::coroutine_handle<promise_type> h) : handle(h) {}
-
-    ~Task() {
-        if (handle) handle.destroy();
-    }
-
-    Task(const Task&) = delete;
-    Task& operator=(const Task&) = delete;
-
-    Task(Task&& other) noexcept : handle(other.handle) {
-        other.handle = nullptr;
-    }
-
-    Task& operator=(Task&& other) noexcept {
-        if (this != &other) {
-            if (handle) handle.destroy();
-            handle = other.handle;
-            other.handle = nullptr;
-        }
-        return *this;
-    }
-
-    T get() {
-        if (!handle.done()) {
-            handle.resume();
-        }
-        if (handle.promise().exception) {
-            std::rethrow_exception(handle.promise().exception);
-        }
-        return handle.promise().value;
-    }
-
-    bool is_ready() const {
-        return handle.done();
-    }
-};
+// Task<T> (task.h) starts running immediately and can be co_await'ed from
+// another Task, which is resumed by symmetric transfer when it finishes.
 
 // Simple async computation
 Task<int> compute_answer() {
@@ -186,34 +87,72 @@ Task<std::string> format_result(int value) {
     co_return "The answer is: " + std::to_string(value);
 }
 
+// Awaits one task from another: each co_await resumes right here when the
+// awaited task finishes, without the caller driving the chain
+Task<std::string> answer_chain() {
+    int value = co_await compute_answer();
+    std::cout << "[Chain Task] compute_answer() finished with " << value << "\n";
+    co_return co_await format_result(value);
+}
+
 // ============================================================================
 // EXAMPLE 3: Custom Awaiter - Sleep operation
 // ============================================================================
 
+enum class SleepStatus { completed, cancelled };
+
 struct SleepAwaiter {
+    explicit SleepAwaiter(std::chrono::milliseconds d) : duration(d) {}
+
     std::chrono::milliseconds duration;
+    std::coroutine_handle<> waiter;
+    TimerService::Timer timer;
+    SleepStatus status = SleepStatus::completed;
 
     // Check if we can skip suspension
     bool await_ready() const noexcept {
-        std::cout << "[Awaiter] Checking if sleep is needed...\n";
         return duration.count() <= 0;
     }
 
-    // Called when suspending - schedule resume
-    void await_suspend(std::coroutine_handle<> handle) const {
-        std::cout << "[Awaiter] Suspending for " << duration.count() << "ms\n";
+    // Called when suspending - register with the shared timer thread. If
+    // the awaiting task has a stop token, a stop request cancels the timer
+    // and resumes us immediately.
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> handle) {
+        waiter = handle;
+        COROUTINE_TRACE_EVENT("sleep", handle.address(), duration.count());
 
-        std::thread([handle, d = duration]() {
-            std::this_thread::sleep_for(d);
-            std::cout << "[Awaiter Thread] Sleep complete, resuming coroutine\n";
-            handle.resume();
-        }).detach();
+        if (std::stop_token token = detail::stop_token_of(handle); token.stop_possible()) {
+            on_stop.emplace(token, CancelOnStop{this});
+        }
+        auto deadline = TimerService::clock::now() + duration;
+        if (!TimerService::instance().schedule(timer, deadline, handle)) {
+            status = SleepStatus::cancelled;  // Stopped before we got here
+            return false;
+        }
+        return true;
     }
 
     // Called when resuming - return result
-    void await_resume() const noexcept {
-        std::cout << "[Awaiter] Resumed after sleep\n";
+    SleepStatus await_resume() noexcept {
+        on_stop.reset();
+        COROUTINE_TRACE_EVENT("woke", waiter.address(), status == SleepStatus::cancelled);
+        return status;
     }
+
+private:
+    struct CancelOnStop {
+        SleepAwaiter* self;
+
+        void operator()() const noexcept {
+            if (TimerService::instance().cancel(self->timer)) {
+                self->status = SleepStatus::cancelled;
+                self->waiter.resume();
+            }
+        }
+    };
+
+    std::optional<std::stop_callback<CancelOnStop>> on_stop;
 };
 
 // Helper function to create awaiter
@@ -251,6 +190,194 @@ Generator<std::string> lifecycle_demo() {
     // When co_return or end of function is reached, final_suspend is called
 }
 
+// ============================================================================
+// EXAMPLE 5: Scheduler - Moving tasks onto worker threads
+// ============================================================================
+
+// Starts on the caller's thread, then hops onto a scheduler worker
+Task<long> sum_on_worker(Scheduler& scheduler, int begin, int end) {
+    co_await scheduler.schedule();  // Everything below runs on a worker
+
+    long sum = 0;
+    for (int i = begin; i < end; ++i) {
+        sum += i;
+    }
+
+    co_return sum;
+}
+
+// ============================================================================
+// EXAMPLE 6: Zero-copy generators - Yielding by reference
+// ============================================================================
+
+// Hands out the caller's strings without copying any of them
+Generator<const std::string&> longest_first(const std::vector<std::string>& words) {
+    std::size_t longest = 0;
+    for (std::size_t i = 1; i < words.size(); ++i) {
+        if (words[i].size() > words[longest].size()) longest = i;
+    }
+
+    co_yield words[longest];
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        if (i != longest) co_yield words[i];
+    }
+}
+
+// Builds each line in a temporary; the consumer can take() it without a copy
+Generator<std::string> numbered_lines(int count) {
+    for (int i = 1; i <= count; ++i) {
+        co_yield "line " + std::to_string(i);
+    }
+}
+
+// ============================================================================
+// EXAMPLE 7: Lazy tasks - Nothing runs until someone awaits
+// ============================================================================
+
+LazyTask<int> square_later(int value) {
+    std::cout << "[Lazy Task] Squaring " << value << "\n";
+    co_return value * value;
+}
+
+// Each co_await starts one lazy task and resumes here when it finishes
+Task<int> sum_of_squares(std::vector<LazyTask<int>> batch) {
+    int total = 0;
+    for (auto& task : batch) {
+        total += co_await task;
+    }
+    co_return total;
+}
+
+// ============================================================================
+// EXAMPLE 8: when_all / when_any - Fan out and join
+// ============================================================================
+
+LazyTask<std::string> lookup_user(int id) {
+    co_return "user" + std::to_string(id);
+}
+
+// All three lookups are in flight together; the tuple arrives when the last
+// one finishes. Tasks that suspend (timers, schedulers) overlap in time.
+Task<std::string> fan_out() {
+    auto [name, square, label] = co_await when_all(lookup_user(7), square_later(12), lookup_user(8));
+    co_return name + " " + std::to_string(square) + " " + label;
+}
+
+// Continues with whichever replica answers first
+Task<int> first_replica() {
+    std::vector<LazyTask<int>> replicas;
+    for (int i = 2; i <= 4; ++i) {
+        replicas.push_back(square_later(i));
+    }
+    auto first = co_await when_any(std::move(replicas));
+    std::cout << "[Any Task] Replica " << first.index << " answered first\n";
+    co_return first.value;
+}
+
+// ============================================================================
+// EXAMPLE 9: Cancellation - Abandoning a sleep through a stop token
+// ============================================================================
+
+// The leading std::stop_token becomes the task's token (cancellation.h);
+// sleep_for() watches it and wakes early when a stop is requested
+Task<int> cancellable_computation(std::stop_token) {
+    SleepStatus status = co_await sleep_for(std::chrono::milliseconds(500));
+    if (status == SleepStatus::cancelled) {
+        std::cout << "[Cancellable Task] Sleep cancelled, giving up\n";
+        co_return -1;
+    }
+    co_return 42;
+}
+
+// ============================================================================
+// EXAMPLE 10: Structured concurrency - Spawning into a scope and joining
+// ============================================================================
+
+LazyTask<int> staggered_job(int id) {
+    co_await sleep_for(std::chrono::milliseconds(10 * id));
+    std::cout << "[Scope Job " << id << "] Done\n";
+    co_return id;
+}
+
+// Nothing spawned here outlives the co_await on join()
+Task<int> run_jobs(int count) {
+    AsyncScope scope;
+    for (int id = 1; id <= count; ++id) {
+        scope.spawn(staggered_job(id));
+    }
+    std::cout << "[Scope] Spawned " << scope.pending() << " jobs\n";
+    co_await scope.join();
+    co_return count;
+}
+
+// ============================================================================
+// EXAMPLE 11: Async generators - Waiting between elements
+// ============================================================================
+
+// Each reading arrives after a timer fires; nothing is buffered up front
+AsyncGenerator<int> sensor_readings(int count) {
+    for (int i = 1; i <= count; ++i) {
+        co_await sleep_for(std::chrono::milliseconds(20));
+        co_yield i * 10;
+    }
+}
+
+Task<int> average_reading(int count) {
+    int total = 0;
+    auto readings = sensor_readings(count);
+    for (auto it = co_await readings.begin(); it != readings.end(); co_await ++it) {
+        std::cout << "[Async Generator] Reading " << *it << "\n";
+        total += *it;
+    }
+    co_return total / count;
+}
+
+// ============================================================================
+// EXAMPLE 12: Batched generators - One resume per batch of values
+// ============================================================================
+
+// Values go into a buffer in the frame; the consumer sees spans of up to 256
+BatchedGenerator<int> squares_batched(int count) {
+    for (int i = 1; i <= count; ++i) {
+        co_yield i * i;
+    }
+}
+
+// ============================================================================
+// EXAMPLE 13: Fused pipelines - Stages without frames of their own
+// ============================================================================
+
+// Squares of the odd numbers in [start, end); map and filter run inside
+// the loop that drains range(), not in generators of their own
+std::vector<int> odd_squares(int start, int end, std::size_t limit) {
+    return range(start, end)
+         | fuse::filter([](int v) { return v % 2 != 0; })
+         | fuse::map([](int v) { return v * v; })
+         | fuse::take(limit)
+         | fuse::to_vector();
+}
+
+// ============================================================================
+// EXAMPLE 14: Interleaved lookups - Overlapping cache misses
+// ============================================================================
+
+// Binary search that prefetches each probe and lets the other searches in
+// its group run while the line is loading
+Interleaved<std::size_t> find_position(const std::vector<int>& sorted, int key) {
+    std::size_t low = 0, count = sorted.size();
+    while (count > 0) {
+        std::size_t half = count / 2;
+        co_await prefetch(&sorted[low + half]);
+        if (sorted[low + half] < key) {
+            low += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    co_return low;
+}
+
 // ============================================================================
 // Main function - Run all examples
 // ============================================================================
@@ -275,11 +402,22 @@ int main() {
     // Example 2: Generator - Range
     std::cout << "--- Example 2: Range Generator ---\n";
     {
-        auto r = range(5, 10);
         std::cout << "\n[Main] Numbers in range: ";
 
-        while (r.next()) {
-            std::cout << r.value() << " ";
+        // begin() starts the coroutine, each ++ resumes it
+        for (int value : range(5, 10)) {
+            std::cout << value << " ";
+        }
+        std::cout << "\n";
+
+        // Generators are views, so they feed range adaptors directly
+        auto odd_squares = range(1, 10)
+                         | std::views::filter([](int v) { return v % 2 == 1; })
+                         | std::views::transform([](int v) { return v * v; });
+
+        std::cout << "[Main] Odd squares: ";
+        for (int value : odd_squares) {
+            std::cout << value << " ";
         }
         std::cout << "\n\n";
     }
@@ -297,11 +435,8 @@ int main() {
     // Example 4: Task chain
     std::cout << "--- Example 4: Task Chain ---\n";
     {
-        auto task1 = compute_answer();
-        int value = task1.get();
-
-        auto task2 = format_result(value);
-        std::string message = task2.get();
+        auto chain = answer_chain();
+        std::string message = chain.get();
 
         std::cout << "[Main] Final message: " << message << "\n\n";
     }
@@ -314,9 +449,6 @@ int main() {
 
         int result = task.get();
         std::cout << "[Main] Got delayed result: " << result << "\n\n";
-
-        // Give background thread time to complete
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
     // Example 6: Coroutine lifecycle
@@ -351,7 +483,143 @@ int main() {
     }
     std::cout << "[Main] Lifecycle demo destroyed\n\n";
 
+    // Example 7: Work-stealing scheduler
+    std::cout << "--- Example 7: Tasks on a Work-Stealing Scheduler ---\n";
+    {
+        constexpr int chunks = 4;
+        Scheduler scheduler(2);
+        std::cout << "[Main] Scheduler started with " << scheduler.thread_count() << " workers\n";
+
+        std::vector<Task<long>> tasks;
+        for (int i = 0; i < chunks; ++i) {
+            tasks.push_back(sum_on_worker(scheduler, i * 1000, (i + 1) * 1000));
+        }
+
+        // get() parks this thread until the worker running the task is done
+        long total = 0;
+        for (auto& task : tasks) {
+            total += task.get();
+        }
+        std::cout << "[Main] Sum of 0..3999 computed on workers: " << total << "\n\n";
+    }
+
+    // Example 8: Yielding by reference
+    std::cout << "--- Example 8: Zero-Copy Generators ---\n";
+    {
+        std::vector<std::string> words{"co_await", "co_yield", "symmetric_transfer", "frame"};
+
+        auto refs = longest_first(words);
+        std::cout << "[Main] Words, longest first:";
+        while (refs.next()) {
+            const std::string& word = refs.value();  // Refers into `words`
+            std::cout << " " << word;
+        }
+        std::cout << "\n";
+
+        std::vector<std::string> lines;
+        auto gen = numbered_lines(3);
+        while (gen.next()) {
+            lines.push_back(gen.take());  // Moved out of the suspended frame
+        }
+        std::cout << "[Main] Took " << lines.size() << " lines, last: " << lines.back() << "\n\n";
+    }
+
+    // Example 9: Lazy tasks
+    std::cout << "--- Example 9: Lazy Tasks ---\n";
+    {
+        std::vector<LazyTask<int>> batch;
+        for (int i = 1; i <= 3; ++i) {
+            batch.push_back(square_later(i));
+        }
+        std::cout << "[Main] Built " << batch.size() << " lazy tasks, none has run yet\n";
+
+        auto total = sum_of_squares(std::move(batch));
+        std::cout << "[Main] Sum of squares: " << total.get() << "\n\n";
+    }
+
+    // Example 10: Combinators
+    std::cout << "--- Example 10: when_all / when_any ---\n";
+    {
+        auto joined = fan_out();
+        std::cout << "[Main] when_all result: " << joined.get() << "\n";
+
+        auto fastest = first_replica();
+        std::cout << "[Main] when_any result: " << fastest.get() << "\n\n";
+    }
+
+    // Example 11: Cancellation
+    std::cout << "--- Example 11: Cancellation ---\n";
+    {
+        std::stop_source stop;
+        auto start = std::chrono::steady_clock::now();
+        auto task = cancellable_computation(stop.get_token());
+        stop.request_stop();  // Resumes the sleeping task now, not in 500ms
+
+        int result = task.get();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "[Main] Cancelled task returned " << result << " after " << elapsed.count() << "ms\n\n";
+    }
+
+    // Example 12: Structured concurrency
+    std::cout << "--- Example 12: AsyncScope ---\n";
+    {
+        int finished = run_jobs(3).get();
+        std::cout << "[Main] All " << finished << " jobs joined\n\n";
+    }
+
+    // Example 13: Async generator
+    std::cout << "--- Example 13: AsyncGenerator ---\n";
+    {
+        int average = average_reading(3).get();
+        std::cout << "[Main] Average reading: " << average << "\n\n";
+    }
+
+    // Example 14: Batched generator
+    std::cout << "--- Example 14: BatchedGenerator ---\n";
+    {
+        long total = 0;
+        int batches = 0;
+        for (std::span<int> batch : squares_batched(1000)) {
+            for (int value : batch) total += value;  // Tight loop over a contiguous span
+            ++batches;
+        }
+        std::cout << "[Main] Sum of 1000 squares: " << total << " in " << batches << " batches\n\n";
+    }
+
+    // Example 15: Fused pipeline
+    std::cout << "--- Example 15: Fused pipeline ---\n";
+    {
+        std::vector<int> squares = odd_squares(0, 100, 5);
+        std::cout << "[Main] First 5 odd squares:";
+        for (int value : squares) std::cout << " " << value;
+        std::cout << "\n\n";
+    }
+
+    // Example 16: Interleaved lookups
+    std::cout << "--- Example 16: InterleavedExecutor ---\n";
+    {
+        std::vector<int> sorted;
+        for (int i = 0; i < 1000; ++i) sorted.push_back(i * 10);
+
+        std::vector<int> keys = {250, 9990, 0, 4321};
+        std::vector<std::size_t> positions(keys.size());
+        InterleavedExecutor executor(4);  // All four searches in flight at once
+        executor.run(keys, [&](int key) { return find_position(sorted, key); },
+                     [&](std::size_t index, std::size_t position) { positions[index] = position; });
+
+        std::cout << "[Main] Positions:";
+        for (std::size_t position : positions) std::cout << " " << position;
+        std::cout << "\n\n";
+    }
+
     std::cout << "=== All Examples Complete ===\n";
 
+    // Built with COROUTINE_TRACE=1: open this file in https://ui.perfetto.dev
+    if constexpr (trace::enabled) {
+        std::ofstream out("coroutine_trace.json");
+        trace::write_chrome_trace(out, trace::snapshot());
+        std::cout << "Trace written to coroutine_trace.json\n";
+    }
+
     return 0;
 }